@@ -3,7 +3,10 @@
 #include "../../Helpers/Translations.h"
 #include "../../Helpers/STDHelpers.h"
 
+#include "../../Miscs/DocumentVersion.h"
 #include "../../Miscs/TheaterInfo.h"
+#include "../../Miscs/RedrawScheduler.h"
+#include "../../Miscs/TypeClassification.h"
 
 #include "../../FA2sp.h"
 
@@ -12,12 +15,10 @@
 #include <CIsoView.h>
 #include <CTileTypeClass.h>
 
+#include <chrono>
+
 std::array<HTREEITEM, ObjectBrowserControlExt::Root_Count> ObjectBrowserControlExt::ExtNodes;
-std::set<ppmfc::CString> ObjectBrowserControlExt::IgnoreSet;
-std::set<ppmfc::CString> ObjectBrowserControlExt::ForceName;
-std::set<ppmfc::CString> ObjectBrowserControlExt::ExtSets[Set_Count];
-std::map<ppmfc::CString, int> ObjectBrowserControlExt::KnownItem;
-std::map<ppmfc::CString, int> ObjectBrowserControlExt::Owners;
+std::array<unsigned long long, ObjectBrowserControlExt::Root_Count> ObjectBrowserControlExt::Signatures;
 
 std::unique_ptr<CPropertyBuilding> ObjectBrowserControlExt::BuildingBrushDlg;
 std::unique_ptr<CPropertyInfantry> ObjectBrowserControlExt::InfantryBrushDlg;
@@ -45,93 +46,142 @@ HTREEITEM ObjectBrowserControlExt::InsertTranslatedString(const char* pOriginStr
 
 ppmfc::CString ObjectBrowserControlExt::QueryUIName(const char* pRegName)
 {
-    if (ForceName.find(pRegName) != ForceName.end())
+    if (TypeClassification::IsForceName(pRegName))
         return Variables::Rules.GetString(pRegName, "Name", pRegName);
     else
-        return CMapData::GetUIName(pRegName);
+        return TypeClassification::GetUIName(pRegName);
 }
 
 void ObjectBrowserControlExt::Redraw()
 {
-    Redraw_Initialize();
-    Redraw_MainList();
-    Redraw_Ground();
-    Redraw_Owner();
-    Redraw_Infantry();
-    Redraw_Vehicle();
-    Redraw_Aircraft();
-    Redraw_Building();
-    Redraw_Terrain();
-    Redraw_Smudge();
-    Redraw_Overlay();
-    Redraw_Waypoint();
-    Redraw_Celltag();
-    Redraw_Basenode();
-    Redraw_Tunnel();
-    Redraw_PlayerLocation(); // player location is just waypoints!
-    Redraw_PropertyBrush();
-}
+    auto begin = std::chrono::steady_clock::now();
 
-void ObjectBrowserControlExt::Redraw_Initialize()
-{
-    for (auto root : ExtNodes)
-        root = NULL;
-    KnownItem.clear();
-    IgnoreSet.clear();
-    ForceName.clear();
-    Owners.clear();
-    this->DeleteAllItems();
+    // The category roots are only inserted once, unless the tree was emptied
+    if (!ExtNodes[Root_Nothing] || !TreeView_GetCount(this->m_hWnd))
+    {
+        this->DeleteAllItems();
+        ExtNodes.fill(NULL);
+        Signatures.fill(0);
+        Redraw_MainList();
+    }
 
-    auto& rules = CINI::Rules();
-    auto& fadata = CINI::FAData();
-    auto& doc = CINI::CurrentDocument();
+    Redraw_Initialize();
 
-    auto loadSet = [](const char* pTypeName, int nType)
-    {
-        ExtSets[nType].clear();
-        auto& section = Variables::Rules.GetSection(pTypeName);
-        for (auto& itr : section)
-            ExtSets[nType].insert(itr.second);
+    using RedrawFunction = void(ObjectBrowserControlExt::*)();
+    static constexpr std::pair<int, RedrawFunction> Categories[] =
+    {
+        { Root_Ground, &ObjectBrowserControlExt::Redraw_Ground },
+        { Root_Owner, &ObjectBrowserControlExt::Redraw_Owner },
+        { Root_Infantry, &ObjectBrowserControlExt::Redraw_Infantry },
+        { Root_Vehicle, &ObjectBrowserControlExt::Redraw_Vehicle },
+        { Root_Aircraft, &ObjectBrowserControlExt::Redraw_Aircraft },
+        { Root_Building, &ObjectBrowserControlExt::Redraw_Building },
+        { Root_Terrain, &ObjectBrowserControlExt::Redraw_Terrain },
+        { Root_Smudge, &ObjectBrowserControlExt::Redraw_Smudge },
+        { Root_Overlay, &ObjectBrowserControlExt::Redraw_Overlay },
+        { Root_Waypoint, &ObjectBrowserControlExt::Redraw_Waypoint },
+        { Root_Celltag, &ObjectBrowserControlExt::Redraw_Celltag },
+        { Root_Basenode, &ObjectBrowserControlExt::Redraw_Basenode },
+        { Root_Tunnel, &ObjectBrowserControlExt::Redraw_Tunnel },
+        { Root_PlayerLocation, &ObjectBrowserControlExt::Redraw_PlayerLocation }, // player location is just waypoints!
+        { Root_PropertyBrush, &ObjectBrowserControlExt::Redraw_PropertyBrush },
     };
 
-    loadSet("BuildingTypes", Set_Building);
-    loadSet("InfantryTypes", Set_Infantry);
-    loadSet("VehicleTypes", Set_Vehicle);
-    loadSet("AircraftTypes", Set_Aircraft);
+    std::array<unsigned long long, Root_Count> signatures;
+    for (auto& category : Categories)
+        signatures[category.first] = GetSignature(category.first);
 
-    if (ExtConfigs::BrowserRedraw_GuessMode == 1)
+    int nRebuilt = 0;
+    for (auto& category : Categories)
     {
-        auto loadOwner = []()
-        {
-            auto& sides = Variables::Rules.ParseIndicies("Sides", true);
-            for (size_t i = 0, sz = sides.size(); i < sz; ++i)
-                for (auto& owner : STDHelpers::SplitString(sides[i]))
-                    Owners[owner] = i;
-        };
-        loadOwner();
+        if (signatures[category.first] == Signatures[category.first])
+            continue;
+        DeleteChildren(ExtNodes[category.first]);
+        (this->*category.second)();
+        Signatures[category.first] = signatures[category.first];
+        ++nRebuilt;
     }
 
-    if (auto knownSection = fadata.GetSection("ForceSides"))
+    auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    Logger::Debug("ObjectBrowserControl : Redraw rebuilt %d of %d categories in %d us.\n",
+        nRebuilt, static_cast<int>(std::size(Categories)), static_cast<int>(time));
+}
+
+unsigned long long ObjectBrowserControlExt::GetSignature(int nRoot)
+{
+    // Hash of everything the category is built from
+    unsigned long long nHash = STDHelpers::FNVOffsetBasis64;
+    auto AddString = [&nHash](const char* pString)
     {
-        for (auto& item : knownSection->GetEntities())
-        {
-            int sideIndex = STDHelpers::ParseToInt(item.second, -1);
-            if (sideIndex >= fadata.GetKeyCount("Sides"))
-                continue;
-            if (sideIndex < -1)
-                sideIndex = -1;
-            KnownItem[item.first] = sideIndex;
-        }
+        STDHelpers::HashString(nHash, pString);
+    };
+    auto AddInt = [&AddString](int n)
+    {
+        char buffer[12];
+        _itoa_s(n, buffer, 10);
+        AddString(buffer);
+    };
+    auto AddSection = [&nHash](CINI* pINI, const char* pSection)
+    {
+        STDHelpers::HashSection(nHash, pINI, pSection);
+    };
+    AddInt(nRoot);
+    switch (nRoot)
+    {
+    case Root_Ground:
+        AddString(CINI::CurrentDocument->GetString("Map", "Theater"));
+        AddInt(CINI::CurrentTheater ? 1 : 0);
+        for (auto& morphables : TheaterInfo::CurrentInfo)
+            AddInt(morphables.Morphable);
+        break;
+    case Root_Owner:
+        AddInt(ExtConfigs::BrowserRedraw_SafeHouses);
+        AddInt(CMapData::Instance->IsMultiOnly());
+        AddSection(&CINI::Rules(), "Countries");
+        AddSection(&CINI::Rules(), "Houses");
+        AddSection(&CINI::CurrentDocument(), "Houses");
+        break;
+    case Root_Infantry:
+    case Root_Vehicle:
+    case Root_Aircraft:
+    case Root_Building:
+        // Redraw_Initialize updated the classification already, it hashed the type lists,
+        // the sections of the types and everything their sides are guessed from
+        AddInt(ExtConfigs::BrowserRedraw_CleanUp);
+        AddInt(static_cast<int>(TypeClassification::GetVersion()));
+        break;
+    case Root_Terrain:
+    case Root_Smudge:
+    case Root_Overlay:
+        // Their type lists and sections only change with the document, [IgnoreRA2]
+        // is read by the classification and moves its version
+        AddInt(static_cast<int>(DocumentVersion::Get()));
+        AddInt(static_cast<int>(TypeClassification::GetVersion()));
+        break;
+    case Root_Tunnel:
+        AddInt(CINI::FAData->GetBool("Debug", "AllowTunnels"));
+        break;
+    case Root_PlayerLocation:
+        AddInt(CMapData::Instance->IsMultiOnly());
+        break;
+    default:
+        break;
     }
 
-    if (auto ignores = fadata.GetSection("IgnoreRA2"))
-        for (auto& item : ignores->GetEntities())
-            IgnoreSet.insert(item.second);
+    return nHash;
+}
 
-    if (auto forcenames = fadata.GetSection("ForceName"))
-        for (auto& item : forcenames->GetEntities())
-            ForceName.insert(item.second);
+void ObjectBrowserControlExt::DeleteChildren(HTREEITEM hParent)
+{
+    if (hParent == NULL)
+        return;
+    while (auto hChild = TreeView_GetChild(this->m_hWnd, hParent))
+        this->DeleteItem(hChild);
+}
 
+void ObjectBrowserControlExt::Redraw_Initialize()
+{
+    TypeClassification::Update();
 }
 
 void ObjectBrowserControlExt::Redraw_MainList()
@@ -263,18 +313,15 @@ void ObjectBrowserControlExt::Redraw_Infantry()
     }
     subNodes[-1] = this->InsertTranslatedString("OthObList", -1, hInfantry);
 
-    auto& infantries = Variables::Rules.GetSection("InfantryTypes");
-    for (auto& inf : infantries)
+    for (auto& [index, pInfantry] : TypeClassification::GetTypes(TypeClassification::Infantry))
     {
-        if (IgnoreSet.find(inf.second) != IgnoreSet.end())
+        if (pInfantry->Ignored || index == -1)
             continue;
-        int index = STDHelpers::ParseToInt(inf.first, -1);
-        if (index == -1)   continue;
-        int side = GuessSide(inf.second, Set_Infantry);
+        int side = pInfantry->Side;
         if (subNodes.find(side) == subNodes.end())
             side = -1;
         this->InsertString(
-            QueryUIName(inf.second),
+            QueryUIName(pInfantry->RegName),
             Const_Infantry + index,
             subNodes[side]
         );
@@ -312,18 +359,15 @@ void ObjectBrowserControlExt::Redraw_Vehicle()
     }
     subNodes[-1] = this->InsertTranslatedString("OthObList", -1, hVehicle);
 
-    auto& vehicles = Variables::Rules.GetSection("VehicleTypes");
-    for (auto& veh : vehicles)
+    for (auto& [index, pVehicle] : TypeClassification::GetTypes(TypeClassification::Vehicle))
     {
-        if (IgnoreSet.find(veh.second) != IgnoreSet.end())
+        if (pVehicle->Ignored || index == -1)
             continue;
-        int index = STDHelpers::ParseToInt(veh.first, -1);
-        if (index == -1)   continue;
-        int side = GuessSide(veh.second, Set_Vehicle);
+        int side = pVehicle->Side;
         if (subNodes.find(side) == subNodes.end())
             side = -1;
         this->InsertString(
-            QueryUIName(veh.second),
+            QueryUIName(pVehicle->RegName),
             Const_Vehicle + index,
             subNodes[side]
         );
@@ -362,18 +406,15 @@ void ObjectBrowserControlExt::Redraw_Aircraft()
     }
     subNodes[-1] = this->InsertTranslatedString("OthObList", -1, hAircraft);
 
-    auto& aircrafts = Variables::Rules.GetSection("AircraftTypes");
-    for (auto& air : aircrafts)
+    for (auto& [index, pAircraft] : TypeClassification::GetTypes(TypeClassification::Aircraft))
     {
-        if (IgnoreSet.find(air.second) != IgnoreSet.end())
+        if (pAircraft->Ignored || index == -1)
             continue;
-        int index = STDHelpers::ParseToInt(air.first, -1);
-        if (index == -1)   continue;
-        int side = GuessSide(air.second, Set_Aircraft);
+        int side = pAircraft->Side;
         if (subNodes.find(side) == subNodes.end())
             side = -1;
         this->InsertString(
-            QueryUIName(air.second),
+            QueryUIName(pAircraft->RegName),
             Const_Aircraft + index,
             subNodes[side]
         );
@@ -412,18 +453,15 @@ void ObjectBrowserControlExt::Redraw_Building()
     }
     subNodes[-1] = this->InsertTranslatedString("OthObList", -1, hBuilding);
 
-    auto& buildings = Variables::Rules.GetSection("BuildingTypes");
-    for (auto& bud : buildings)
+    for (auto& [index, pBuilding] : TypeClassification::GetTypes(TypeClassification::Building))
     {
-        if (IgnoreSet.find(bud.second) != IgnoreSet.end())
+        if (pBuilding->Ignored || index == -1)
             continue;
-        int index = STDHelpers::ParseToInt(bud.first, -1);
-        if (index == -1)   continue;
-        int side = GuessSide(bud.second, Set_Building);
+        int side = pBuilding->Side;
         if (subNodes.find(side) == subNodes.end())
             side = -1;
         this->InsertString(
-            QueryUIName(bud.second),
+            QueryUIName(pBuilding->RegName),
             Const_Building + index,
             subNodes[side]
         );
@@ -461,7 +499,7 @@ void ObjectBrowserControlExt::Redraw_Terrain()
     {
         FA2sp::Buffer = QueryUIName(terrains[i]);
         FA2sp::Buffer += "(" + terrains[i] + ")";
-        if (IgnoreSet.find(terrains[i]) == IgnoreSet.end())
+        if (!TypeClassification::IsIgnored(terrains[i]))
         {
             if (terrains[i].Find("TREE") >= 0)  this->InsertString(FA2sp::Buffer, Const_Terrain + i, hTree);
             else if (terrains[i].Find("TRFF") >= 0)  this->InsertString(FA2sp::Buffer, Const_Terrain + i, hTrff);
@@ -480,7 +518,7 @@ void ObjectBrowserControlExt::Redraw_Smudge()
     auto& smudges = Variables::Rules.ParseIndicies("SmudgeTypes", true);
     for (size_t i = 0, sz = smudges.size(); i < sz; ++i)
     {
-        if (IgnoreSet.find(smudges[i]) == IgnoreSet.end())
+        if (!TypeClassification::IsIgnored(smudges[i]))
             this->InsertString(smudges[i], Const_Smudge + i, hSmudge);
     }
 }
@@ -537,7 +575,7 @@ void ObjectBrowserControlExt::Redraw_Overlay()
                 Const_Overlay + i,
                 hWalls
             );
-        if (IgnoreSet.find(overlays[i]) == IgnoreSet.end())
+        if (!TypeClassification::IsIgnored(overlays[i]))
             this->InsertString(buffer, Const_Overlay + i, hTemp);
     }
 }
@@ -685,6 +723,8 @@ void ObjectBrowserControlExt::ApplyPropertyBrush(int X, int Y)
         if (CellData.Aircraft != -1)
             ApplyPropertyBrush_Aircraft(CellData.Aircraft);
     }
+
+    RedrawScheduler::RequestCell(X, Y, RedrawScheduler::ObjectCellMargin);
 }
 
 void ObjectBrowserControlExt::ApplyPropertyBrush_Building(int nIndex)
@@ -718,8 +758,6 @@ void ObjectBrowserControlExt::ApplyPropertyBrush_Building(int nIndex)
 
     CMapData::Instance->DeleteStructureData(nIndex);
     CMapData::Instance->SetStructureData(data, nullptr, nullptr, 0, "");
-
-    ::RedrawWindow(CFinalSunDlg::Instance->MyViewFrame.pIsoView->m_hWnd, 0, 0, RDW_UPDATENOW | RDW_INVALIDATE);
 }
 
 void ObjectBrowserControlExt::ApplyPropertyBrush_Infantry(int nIndex)
@@ -749,8 +787,6 @@ void ObjectBrowserControlExt::ApplyPropertyBrush_Infantry(int nIndex)
 
     CMapData::Instance->DeleteInfantryData(nIndex);
     CMapData::Instance->SetInfantryData(data, nullptr, nullptr, 0, -1);
-
-    ::RedrawWindow(CFinalSunDlg::Instance->MyViewFrame.pIsoView->m_hWnd, 0, 0, RDW_UPDATENOW | RDW_INVALIDATE);
 }
 
 void ObjectBrowserControlExt::ApplyPropertyBrush_Aircraft(int nIndex)
@@ -779,8 +815,6 @@ void ObjectBrowserControlExt::ApplyPropertyBrush_Aircraft(int nIndex)
 
     CMapData::Instance->DeleteAircraftData(nIndex);
     CMapData::Instance->SetAircraftData(data, nullptr, nullptr, 0, "");
-
-    ::RedrawWindow(CFinalSunDlg::Instance->MyViewFrame.pIsoView->m_hWnd, 0, 0, RDW_UPDATENOW | RDW_INVALIDATE);
 }
 
 void ObjectBrowserControlExt::ApplyPropertyBrush_Vehicle(int nIndex)
@@ -811,123 +845,12 @@ void ObjectBrowserControlExt::ApplyPropertyBrush_Vehicle(int nIndex)
 
     CMapData::Instance->DeleteUnitData(nIndex);
     CMapData::Instance->SetUnitData(data, nullptr, nullptr, 0, "");
-
-    ::RedrawWindow(CFinalSunDlg::Instance->MyViewFrame.pIsoView->m_hWnd, 0, 0, RDW_UPDATENOW | RDW_INVALIDATE);
-}
-
-int ObjectBrowserControlExt::GuessType(const char* pRegName)
-{
-    if (ExtSets[Set_Building].find(pRegName) != ExtSets[Set_Building].end())
-        return Set_Building;
-    if (ExtSets[Set_Infantry].find(pRegName) != ExtSets[Set_Infantry].end())
-        return Set_Infantry;
-    if (ExtSets[Set_Vehicle].find(pRegName) != ExtSets[Set_Vehicle].end())
-        return Set_Vehicle;
-    if (ExtSets[Set_Aircraft].find(pRegName) != ExtSets[Set_Aircraft].end())
-        return Set_Aircraft;
-    return -1;
-}
-
-int ObjectBrowserControlExt::GuessSide(const char* pRegName, int nType)
-{
-    auto& knownIterator = KnownItem.find(pRegName);
-    if (knownIterator != KnownItem.end())
-        return knownIterator->second;
-
-    int result = -1;
-    switch (nType)
-    {
-    case -1:
-    default:
-        break;
-    case Set_Building:
-        result = GuessBuildingSide(pRegName);
-        break;
-    case Set_Infantry:
-        result = GuessGenericSide(pRegName, Set_Infantry);
-        break;
-    case Set_Vehicle:
-        result = GuessGenericSide(pRegName, Set_Vehicle);
-        break;
-    case Set_Aircraft:
-        result = GuessGenericSide(pRegName, Set_Aircraft);
-        break;
-    }
-    KnownItem[pRegName] = result;
-    return result;
-}
-
-int ObjectBrowserControlExt::GuessBuildingSide(const char* pRegName)
-{
-    auto& rules = CINI::Rules();
-
-    int planning;
-    planning = rules.GetInteger(pRegName, "AIBasePlanningSide", -1);
-    if (planning >= rules.GetKeyCount("Sides"))
-        return -1;
-    if (planning >= 0)
-        return planning;
-    auto& cons = STDHelpers::SplitString(rules.GetString("AI", "BuildConst"));
-    int i;
-    for (i = 0; i < cons.size(); ++i)
-    {
-        if (cons[i] == pRegName)
-            return i;
-    }
-    if (i >= rules.GetKeyCount("Sides"))
-        return -1;
-    return GuessGenericSide(pRegName, Set_Building);
-}
-
-int ObjectBrowserControlExt::GuessGenericSide(const char* pRegName, int nType)
-{
-    const auto& set = ExtSets[nType];
-
-    if (set.find(pRegName) == set.end())
-        return -1;
-
-    switch (ExtConfigs::BrowserRedraw_GuessMode)
-    {
-    default:
-    case 0:
-    {
-        for (auto& prep : STDHelpers::SplitString(Variables::Rules.GetString(pRegName, "Prerequisite")))
-        {
-            int guess = -1;
-            for (auto& subprep : STDHelpers::SplitString(Variables::Rules.GetString("GenericPrerequisites", prep)))
-            {
-                guess = GuessSide(subprep, GuessType(subprep));
-                if (guess != -1)
-                    return guess;
-            }
-            guess = GuessSide(prep, GuessType(prep));
-            if (guess != -1)
-                return guess;
-        }
-        return -1;
-    }
-    case 1:
-    {
-        auto& owners = STDHelpers::SplitString(Variables::Rules.GetString(pRegName, "Owner"));
-        if (owners.size() <= 0)
-            return -1;
-        auto& itr = Owners.find(owners[0]);
-        if (itr == Owners.end())
-            return -1;
-        return itr->second;
-    }
-    }
 }
 
 // ObjectBrowserControlExt::OnSelectChanged
 void ObjectBrowserControlExt::OnExeTerminate()
 {
-    IgnoreSet.clear();
-    ForceName.clear();
-    for (auto& set : ExtSets)
-        set.clear();
-    KnownItem.clear();
-    Owners.clear();
+    TypeClassification::Clear();
 }
 
 bool ObjectBrowserControlExt::UpdateEngine(int nData)
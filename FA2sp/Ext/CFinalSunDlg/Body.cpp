@@ -41,6 +41,7 @@ BOOL CFinalSunDlgExt::OnCommandExt(WPARAM wParam, LPARAM lParam)
 		if (CFinalSunDlgExt::CurrentLighting != id)
 		{
 			CFinalSunDlgExt::CurrentLighting = id;
+			LightingStruct::Invalidate();
 
 			PalettesManager::ManualReloadTMP = true;
 			PalettesManager::CacheAndTintCurrentIso();
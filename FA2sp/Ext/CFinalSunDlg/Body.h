@@ -45,11 +45,8 @@ class ObjectBrowserControlExt : public ObjectBrowserControl
     };
 
     static std::array<HTREEITEM, Root_Count> ExtNodes;
-    static std::set<ppmfc::CString> IgnoreSet;
-    static std::set<ppmfc::CString> ForceName;
-    static std::set<ppmfc::CString> ExtSets[Set_Count];
-    static std::map<ppmfc::CString, int> KnownItem;
-    static std::map<ppmfc::CString, int> Owners;
+    // Hash of what each category was built from, unchanged categories are kept on redraw
+    static std::array<unsigned long long, Root_Count> Signatures;
     static std::unique_ptr<CPropertyBuilding> BuildingBrushDlg;
     static std::unique_ptr<CPropertyInfantry> InfantryBrushDlg;
     static std::unique_ptr<CPropertyUnit> VehicleBrushDlg;
@@ -59,6 +56,8 @@ class ObjectBrowserControlExt : public ObjectBrowserControl
         HTREEITEM hParent = TVI_ROOT, HTREEITEM hInsertAfter = TVI_LAST);
     HTREEITEM InsertTranslatedString(const char* pOriginString, DWORD dwItemData = 0,
         HTREEITEM hParent = TVI_ROOT, HTREEITEM hInsertAfter = TVI_LAST);
+    unsigned long long GetSignature(int nRoot);
+    void DeleteChildren(HTREEITEM hParent);
     void Redraw_Initialize();
     void Redraw_MainList();
     void Redraw_Ground();
@@ -99,41 +98,4 @@ public:
     static void ApplyPropertyBrush_Vehicle(int nIndex);
     
     ppmfc::CString QueryUIName(const char* pRegName);
-
-public:
-    /// <summary>
-    /// Guess which type does the item belongs to.
-    /// </summary>
-    /// <param name="pRegName">Reg name of the given item.</param>
-    /// <returns>
-    /// The index of type guessed. -1 if cannot be guessed.
-    /// 0 = Building, 1 = Infantry, 2 = Vehicle, 3 = Aircraft
-    /// </returns>
-    static int GuessType(const char* pRegName);
-    /// <summary>
-    /// Guess which side does the item belongs to.
-    /// </summary>
-    /// <param name="pRegName">Reg name of the given item.</param>
-    /// <param name="nType">
-    /// Which type does this item belongs to.
-    /// 0 = Building, 1 = Infantry, 2 = Vehicle, 3 = Aircraft
-    /// </param>
-    /// <returns>The index of side guessed. -1 if cannot be guessed.</returns>
-    static int GuessSide(const char* pRegName, int nType);
-    /// <summary>
-    /// Guess which side does the item belongs to.
-    /// </summary>
-    /// <param name="pRegName">Reg name of the given item.</param>
-    /// <returns>The index of side guessed. -1 if cannot be guessed.</returns>
-    static int GuessBuildingSide(const char* pRegName);
-    /// <summary>
-    /// Guess which side does the item belongs to.
-    /// </summary>
-    /// <param name="pRegName">Reg name of the given item.</param>
-    /// <param name="nType">
-    /// Which type does this item belongs to.
-    /// 0 = Building, 1 = Infantry, 2 = Vehicle, 3 = Aircraft
-    /// </param>
-    /// <returns>The index of side guessed. -1 if cannot be guessed.</returns>
-    static int GuessGenericSide(const char* pRegName, int nType);
 };
@@ -4,6 +4,7 @@
 #include <Helpers/Macro.h>
 
 #include "../../FA2sp.h"
+#include "../../Miscs/MarkerIndex.h"
 #include "../../Miscs/TheaterInfo.h"
 
 #include <CBrushSize.h>
@@ -33,6 +34,9 @@ DEFINE_HOOK(51AF40, ObjectBrowserControl_OnSelectChanged, 7)
 
 DEFINE_HOOK(461766, CIsoView_OnLButtonDown_PropertyBrush, 5)
 {
+    // Waypoints, celltags and tubes are placed and removed by clicks
+    MarkerIndex::MarkDirty();
+
     if (CIsoView::CurrentCommand == 0x17)
     {
         GET(const int, Y, EDI);
@@ -57,7 +61,12 @@ DEFINE_HOOK(45BF73, CIsoView_OnMouseMove_PropertyBrush, 9)
 
         return 0x45CD6D;
     }
-    return CIsoView::CurrentCommand == FACurrentCommand::WaypointHandle ? 0x45BF7C : 0x45C168;
+    if (CIsoView::CurrentCommand == FACurrentCommand::WaypointHandle)
+    {
+        MarkerIndex::MarkDirty();
+        return 0x45BF7C;
+    }
+    return 0x45C168;
 }
 
 // Add a house won't update indices, so there might be hidden risks if not reloading the map.
@@ -9,6 +9,11 @@
 
 #include "../CLoading/Body.h"
 #include "../../Helpers/STDHelpers.h"
+#include "../../Miscs/MarkerIndex.h"
+#include "../../Miscs/ObjectImageBudget.h"
+#include "../../Miscs/RedrawScheduler.h"
+#include "../../Miscs/ObjectLoadQueue.h"
+#include "../../Miscs/Palettes.h"
 
 DEFINE_HOOK(45AF03, CIsoView_StatusBar_YXTOXY_YToX_1, 7)
 {
@@ -109,8 +114,20 @@ DEFINE_HOOK(45ADD0, CIsoView_Draw_CursorSelectionBoundHeightColor, 6)
 //	return 0x474A67;
 //}
 
+DEFINE_HOOK(46DEF7, CIsoView_Draw_Begin, 5)
+{
+	ObjectLoadQueue::IsDrawing = true;
+	ObjectImageBudget::NewFrame();
+	return 0;
+}
+
 DEFINE_HOOK(470194, CIsoView_Draw_LayerVisible_Overlay, 8)
 {
+	float fScrollX = R->Stack<float>(STACK_OFFS(0xD18, 0xCB0));
+	float fScrollY = R->Stack<float>(STACK_OFFS(0xD18, 0xCB8));
+
+	RedrawScheduler::SetViewOrigin(fScrollX, fScrollY);
+
 	return CIsoViewExt::DrawOverlays ? 0 : 0x470772;
 }
 
@@ -181,17 +198,12 @@ DEFINE_HOOK(471162, CIsoView_Draw_PowerUp1Loc_PosFix, 5)
 	GET_STACK(int, X, STACK_OFFS(0xD18, 0xCFC));
 	GET_STACK(int, Y, STACK_OFFS(0xD18, 0xD00));
 
-	auto pBldData = ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(BldID, 0));
-	auto pData = ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(ID, 0));
+	auto& BldInfo = CLoadingExt::GetTypeInfo(BldID);
+	auto pBldData = BldInfo.GetImage(0);
+	auto pData = CLoadingExt::GetTypeInfo(ID).GetImage(0);
 
-	ppmfc::CString ArtID; // BldArtID
-	if (auto ppImage = Variables::Rules.TryGetString(BldID, "Image"))
-		ArtID = *ppImage;
-	else
-		ArtID = BldID;
-
-	X += CINI::Art->GetInteger(ArtID, "PowerUp1LocXX", 0);
-	Y += CINI::Art->GetInteger(ArtID, "PowerUp1LocYY", 0);
+	X += BldInfo.PowerUpLocs[0][0];
+	Y += BldInfo.PowerUpLocs[0][1];
 
 	X += (pBldData->FullWidth - pData->FullWidth) / 2;
 	Y += (pBldData->FullHeight - pData->FullHeight) / 2;
@@ -209,17 +221,12 @@ DEFINE_HOOK(471980, CIsoView_Draw_PowerUp2Loc_PosFix, 5)
 	GET_STACK(int, X, STACK_OFFS(0xD18, 0xCFC));
 	GET_STACK(int, Y, STACK_OFFS(0xD18, 0xD00));
 
-	auto pBldData = ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(BldID, 0));
-	auto pData = ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(ID, 0));
-
-	ppmfc::CString ArtID; // BldArtID
-	if (auto ppImage = Variables::Rules.TryGetString(BldID, "Image"))
-		ArtID = *ppImage;
-	else
-		ArtID = BldID;
+	auto& BldInfo = CLoadingExt::GetTypeInfo(BldID);
+	auto pBldData = BldInfo.GetImage(0);
+	auto pData = CLoadingExt::GetTypeInfo(ID).GetImage(0);
 
-	X += CINI::Art->GetInteger(ArtID, "PowerUp2LocXX", 0);
-	Y += CINI::Art->GetInteger(ArtID, "PowerUp2LocYY", 0);
+	X += BldInfo.PowerUpLocs[1][0];
+	Y += BldInfo.PowerUpLocs[1][1];
 
 	X += (pBldData->FullWidth - pData->FullWidth) / 2;
 	Y += (pBldData->FullHeight - pData->FullHeight) / 2;
@@ -237,17 +244,12 @@ DEFINE_HOOK(4720D3, CIsoView_Draw_PowerUp3Loc_PosFix, 5)
 	GET_STACK(int, X, STACK_OFFS(0xD18, 0xCFC));
 	GET_STACK(int, Y, STACK_OFFS(0xD18, 0xD00));
 
-	auto pBldData = ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(BldID, 0));
-	auto pData = ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(ID, 0));
-
-	ppmfc::CString ArtID; // BldArtID
-	if (auto ppImage = Variables::Rules.TryGetString(BldID, "Image"))
-		ArtID = *ppImage;
-	else
-		ArtID = BldID;
+	auto& BldInfo = CLoadingExt::GetTypeInfo(BldID);
+	auto pBldData = BldInfo.GetImage(0);
+	auto pData = CLoadingExt::GetTypeInfo(ID).GetImage(0);
 
-	X += CINI::Art->GetInteger(ArtID, "PowerUp3LocXX", 0);
-	Y += CINI::Art->GetInteger(ArtID, "PowerUp3LocYY", 0);
+	X += BldInfo.PowerUpLocs[2][0];
+	Y += BldInfo.PowerUpLocs[2][1];
 
 	X += (pBldData->FullWidth - pData->FullWidth) / 2;
 	Y += (pBldData->FullHeight - pData->FullHeight) / 2;
@@ -263,10 +265,11 @@ DEFINE_HOOK(470986, CIsoView_Draw_BuildingImageDataQuery_1, 8)
 	REF_STACK(ImageDataClass, image, STACK_OFFS(0xD18, 0xAFC));
 	REF_STACK(StructureData, structure, STACK_OFFS(0xD18, 0xC0C));
 
+	auto& info = CLoadingExt::GetTypeInfo(structure.ID);
 	int nFacing = 0;
-	if (Variables::Rules.GetBool(structure.ID, "Turret"))
+	if (info.HasTurret)
 		nFacing = 7 - (structure.Facing / 32) % 8;
-	image = *ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(structure.ID, nFacing));
+	image = *info.GetImage(nFacing);
 
 	return 0x4709E1;
 }
@@ -276,10 +279,11 @@ DEFINE_HOOK(470AE3, CIsoView_Draw_BuildingImageDataQuery_2, 7)
 	REF_STACK(ImageDataClass, image, STACK_OFFS(0xD18, 0xAFC));
 	REF_STACK(StructureData, structure, STACK_OFFS(0xD18, 0xC0C));
 
+	auto& info = CLoadingExt::GetTypeInfo(structure.ID);
 	int nFacing = 0;
-	if (Variables::Rules.GetBool(structure.ID, "Turret"))
+	if (info.HasTurret)
 		nFacing = (7 - structure.Facing / 32) % 8;
-	image = *ImageDataMapHelper::GetImageDataFromMap(CLoadingExt::GetImageName(structure.ID, nFacing));
+	image = *info.GetImage(nFacing);
 
 	return 0x470B4D;
 }
@@ -320,37 +324,113 @@ DEFINE_HOOK(4748DC, CIsoView_Draw_SkipCelltagAndWaypointDrawing, 9)
 	return 0x474A91;
 }
 
+// The objects are done here. Hooks sharing an address run in no given order and
+// this one leaves by its own address, so everything ending the object layers is here.
 DEFINE_HOOK(474AE3, CIsoView_Draw_DrawCelltagAndWaypointAndTube_EarlyUnlock, 6)
 {
 	GET_STACK(CIsoViewExt*, pThis, STACK_OFFS(0xD18, 0xCD4));
 
-	pThis->lpDDBackBufferSurface->Unlock(nullptr);
+	ObjectLoadQueue::IsDrawing = false;
 
-	return pThis ? 0x474AEF : 0x474DB3;
-}
+	// Vehicles, aircrafts and infantries still queued get a dotted outline on their cell,
+	// buildings have FA2's own one. Only walked while something is queued.
+	if (ObjectLoadQueue::HasPending())
+	{
+		GET_STACK(const int, jMin, STACK_OFFS(0xD18, 0xC10));
+		GET_STACK(const int, iMin, STACK_OFFS(0xD18, 0xCBC));
+		GET_STACK(const int, jMax, STACK_OFFS(0xD18, 0xC64));
+		GET_STACK(const int, iMax, STACK_OFFS(0xD18, 0xC18));
+		LEA_STACK(LPDDSURFACEDESC2, lpDesc, STACK_OFFS(0xD18, 0x92C));
+		float fScrollX = R->Stack<float>(STACK_OFFS(0xD18, 0xCB0));
+		float fScrollY = R->Stack<float>(STACK_OFFS(0xD18, 0xCB8));
 
-DEFINE_HOOK(474B9D, CIsoView_Draw_DrawCelltagAndWaypointAndTube_DrawStuff, 9)
-{
-	GET_STACK(CIsoViewExt*, pThis, STACK_OFFS(0xD18, 0xCD4));
-	REF_STACK(CellData, celldata, STACK_OFFS(0xD18, 0xC60));
-	int X = R->Stack<int>(STACK_OFFS(0xD18, 0xCE4)) - R->Stack<float>(STACK_OFFS(0xD18, 0xCB0));
-	int Y = R->Stack<int>(STACK_OFFS(0xD18, 0xCD0)) - R->Stack<float>(STACK_OFFS(0xD18, 0xCB8));
-
-	// We had unlocked it already, just blt them now
-	if (CIsoViewExt::DrawCelltags && celldata.CellTag != -1)
-		pThis->DrawCelltag(X, Y);
-	if (CIsoViewExt::DrawWaypoints && celldata.Waypoint != -1)
-		pThis->DrawWaypointFlag(X, Y);
-	if (CIsoViewExt::DrawTubes && celldata.Tube != -1)
-		pThis->DrawTube(&celldata, X, Y);
-
-	return 0x474D64;
+		auto const pMap = &CMapData::Instance();
+		auto IsQueued = [pMap](const CellData& celldata)
+		{
+			if (celldata.Unit != -1)
+			{
+				CUnitData data;
+				pMap->QueryUnitData(celldata.Unit, data);
+				if (ObjectLoadQueue::IsPending(data.TypeID))
+					return true;
+			}
+			if (celldata.Aircraft != -1)
+			{
+				CAircraftData data;
+				pMap->QueryAircraftData(celldata.Aircraft, data);
+				if (ObjectLoadQueue::IsPending(data.TypeID))
+					return true;
+			}
+			for (int nInfantry : celldata.Infantry)
+			{
+				if (nInfantry == -1)
+					continue;
+				CInfantryData data;
+				pMap->QueryInfantryData(nInfantry, data);
+				if (ObjectLoadQueue::IsPending(data.TypeID))
+					return true;
+			}
+			return false;
+		};
+
+		for (int j = jMin; j < jMax; ++j)
+		{
+			for (int i = iMin; i < iMax; ++i)
+			{
+				int nIndex = pMap->GetCoordIndex(i, j);
+				if (nIndex < 0 || nIndex >= pMap->CellDataCount || !IsQueued(pMap->CellDatas[nIndex]))
+					continue;
+
+				int X = j, Y = i;
+				pThis->MapCoord2ScreenCoord(X, Y);
+				X -= fScrollX;
+				Y -= fScrollY;
+				pThis->DrawLockedCellOutline(X, Y, 1, 1, RGB(255, 255, 255), true, false, lpDesc);
+			}
+		}
+	}
+
+	PalettesManager::RestoreCurrentIso();
+	PalettesManager::EndFrame();
+
+	pThis->lpDDBackBufferSurface->Unlock(nullptr);
+
+	// Skip FA2 walking every visible cell, the markers are drawn below
+	return 0x474DB3;
 }
 
 DEFINE_HOOK(474DB7, CIsoView_Draw_DrawCelltagAndWaypointAndTube_SkipOriginUnlock, 6)
 {
 	GET(CIsoViewExt*, pThis, EBX);
 
+	// We had unlocked it already, just blt the markers inside the view now.
+	// The bounds are the ones the waypoint texts read a few instructions later.
+	GET_STACK(const int, jMin, STACK_OFFS(0xD18, 0xC10));
+	GET_STACK(const int, iMin, STACK_OFFS(0xD18, 0xCBC));
+	GET_STACK(const int, jMax, STACK_OFFS(0xD18, 0xC64));
+	GET_STACK(const int, iMax, STACK_OFFS(0xD18, 0xC18));
+	float fScrollX = R->Stack<float>(STACK_OFFS(0xD18, 0xCB0));
+	float fScrollY = R->Stack<float>(STACK_OFFS(0xD18, 0xCB8));
+
+	MarkerIndex::Update();
+	MarkerIndex::ForEachInView(iMin, iMax, jMin, jMax, [&](const MarkerIndex::Marker& marker)
+		{
+			auto& celldata = CMapData::Instance->CellDatas[marker.CellIndex];
+			// Lifted by the cell height already, the same as the waypoint texts below
+			int X = marker.Y, Y = marker.X;
+			pThis->MapCoord2ScreenCoord(X, Y);
+			X -= fScrollX;
+			Y -= fScrollY;
+
+			if (CIsoViewExt::DrawCelltags && celldata.CellTag != -1)
+				pThis->DrawCelltag(X, Y);
+			if (CIsoViewExt::DrawWaypoints && celldata.Waypoint != -1)
+				pThis->DrawWaypointFlag(X, Y);
+			if (CIsoViewExt::DrawTubes && celldata.Tube != -1)
+				pThis->DrawTube(&celldata, X, Y);
+		}
+	);
+
 	R->EAX(pThis->lpDDBackBufferSurface);
 	R->EBP(&pThis->lpDDBackBufferSurface);
 
@@ -379,27 +459,22 @@ DEFINE_HOOK(474DDF, CIsoView_Draw_WaypointTexts, 5)
 			SetBkMode(hDC, TRANSPARENT);
 		SetTextAlign(hDC, TA_CENTER);
 
-		auto pSection = CINI::CurrentDocument->GetSection("Waypoints");
-		for (int j = jMin; j < jMax; ++j)
-		{
-			for (int i = iMin; i < iMax; ++i)
+		MarkerIndex::ForEachInView(iMin, iMax, jMin, jMax, [&](const MarkerIndex::Marker& marker)
 			{
-				int Y = j, X = i;
+				auto pCell = &CMapData::Instance->CellDatas[marker.CellIndex];
+				if (pCell->Waypoint == -1)
+					return;
 
+				int Y = marker.Y, X = marker.X;
 				pThis->MapCoord2ScreenCoord(Y, X);
-				auto pCell = CMapData::Instance->TryGetCellAt(i, j);
 
 				int drawX = Y - R->Stack<float>(STACK_OFFS(0xD18, 0xCB0)) + 30;
 				int drawY = X - R->Stack<float>(STACK_OFFS(0xD18, 0xCB8)) - 15;
 
-				if (pCell->Waypoint != -1)
-				{
-					auto pWP = *pSection->GetKeyAt(pCell->Waypoint);
-					TextOut(hDC, drawX, drawY, pWP, strlen(pWP));
-				}
-
+				auto pWP = MarkerIndex::GetWaypointLabel(pCell->Waypoint);
+				TextOut(hDC, drawX, drawY, pWP, strlen(pWP));
 			}
-		}
+		);
 
 		SetTextAlign(hDC, TA_LEFT);
 		SetTextColor(hDC, RGB(0, 0, 0));
@@ -1,6 +1,7 @@
 #include "Body.h"
 
 #include "../../Helpers/Translations.h"
+#include "../../Miscs/Palettes.h"
 
 #include <CINI.h>
 
@@ -67,6 +68,7 @@ BOOL CLightingExt::PreTranslateMessageExt(MSG* pMsg)
 					pWnd->SetWindowText(buffer);
 				}
 				CINI::CurrentDocument->WriteString("Lighting", pKey, buffer);
+				LightingStruct::Invalidate();
 
 				return true;
 			}
@@ -7,40 +7,120 @@
 #include <Drawing.h>
 #include <CPalette.h>
 
+#include <algorithm>
+
+#include "../../Helpers/ImageScanner.h"
+#include "../../Helpers/STDHelpers.h"
+#include "../../Miscs/DocumentVersion.h"
 #include "../../Miscs/DrawStuff.h"
+#include "../../Miscs/ObjectImageBudget.h"
+#include "../../Miscs/ObjectImageCache.h"
 #include "../../Miscs/Palettes.h"
 #include "../../FA2sp.h"
 
 std::vector<CLoadingExt::SHPUnionData> CLoadingExt::UnionSHP_Data[2];
 std::map<ppmfc::CString, CLoadingExt::ObjectType> CLoadingExt::ObjectTypes;
-unsigned char CLoadingExt::VXL_Data[0x10000] = {0};
+std::map<ppmfc::CString, CLoadingExt::TypeInfo> CLoadingExt::TypeInfos;
+size_t CLoadingExt::TypeInfoQueries = 0;
+size_t CLoadingExt::TypeInfoRebuilds = 0;
+size_t CLoadingExt::VXL_FullBytes = 0;
+size_t CLoadingExt::VXL_CroppedBytes = 0;
 
 ppmfc::CString CLoadingExt::GetImageName(ppmfc::CString ID, int nFacing)
 {
-	ppmfc::CString ImageID;
-	ppmfc::CString DictName;
+	auto& info = GetTypeInfo(ID);
+	if (ExtConfigs::ImageCache_MaxMB > 0 && info.Type != ObjectType::Unknown)
+		info.GetImage(nFacing); // keeps it away from eviction
+	return info.ImageNames[nFacing];
+}
+
+CLoadingExt::TypeInfo& CLoadingExt::GetTypeInfo(ppmfc::CString ID)
+{
+	++TypeInfoQueries;
+
+	auto itr = TypeInfos.find(ID);
+	if (itr != TypeInfos.end())
+	{
+		auto& info = itr->second;
+		if (info.CheckedVersion == DocumentVersion::Get())
+			return info;
+		// Image=, the art and the PowerUp keys may have been edited since
+		if (info.SectionHash == GetTypeSectionHash(ID, info.ArtID))
+		{
+			info.CheckedVersion = DocumentVersion::Get();
+			return info;
+		}
+		++TypeInfoRebuilds;
+	}
+
+	// Filled in place, references handed out before stay valid
 	CLoadingExt* pLoading = (CLoadingExt*)CLoading::Instance();
-	switch (pLoading->GetItemType(ID))
+	auto& info = TypeInfos[ID];
+	info.ID = ID;
+	info.Type = pLoading->GetItemType(ID);
+	info.ArtID = pLoading->GetArtID(ID);
+	info.HasTurret = Variables::Rules.GetBool(ID, "Turret");
+
+	ppmfc::CString ImageID;
+	switch (info.Type)
 	{
 	case ObjectType::Infantry:
-	{
 		ImageID = pLoading->GetInfantryFileID(ID);
-		DictName.Format("%s%d", ImageID, nFacing);
-		return DictName;
-	}
+		break;
 	case ObjectType::Aircraft:
 	case ObjectType::Vehicle:
 		ImageID = pLoading->GetVehicleOrAircraftFileID(ID);
-		DictName.Format("%s%d", ImageID, nFacing);
-		return DictName;
+		break;
 	case ObjectType::Building:
-	 	ImageID = pLoading->GetBuildingFileID(ID);
-	 	DictName.Format("%s%d", ImageID, nFacing);
-	 	return DictName;
+		ImageID = pLoading->GetBuildingFileID(ID);
+		break;
 	default: // NEVER GET TO HERE PLS
-		return "NMSL";
+		break;
 	}
 
+	for (int i = 0; i < 8; ++i)
+	{
+		if (ImageID.IsEmpty())
+			info.ImageNames[i] = "NMSL";
+		else
+			info.ImageNames[i].Format("%s%d", ImageID, i);
+		info.pImages[i] = nullptr;
+	}
+
+	ppmfc::CString key;
+	for (int i = 0; i < 3; ++i)
+	{
+		key.Format("PowerUp%dLocXX", i + 1);
+		info.PowerUpLocs[i][0] = CINI::Art->GetInteger(info.ArtID, key, 0);
+		key.Format("PowerUp%dLocYY", i + 1);
+		info.PowerUpLocs[i][1] = CINI::Art->GetInteger(info.ArtID, key, 0);
+	}
+
+	info.SectionHash = GetTypeSectionHash(ID, info.ArtID);
+	info.CheckedVersion = DocumentVersion::Get();
+
+	return info;
+}
+
+unsigned int CLoadingExt::GetTypeSectionHash(ppmfc::CString ID, ppmfc::CString ArtID)
+{
+	// The rules, map and art sections a type info is read from
+	unsigned int nHash = STDHelpers::FNVOffsetBasis32;
+	STDHelpers::HashSection(nHash, &CINI::Rules(), ID);
+	STDHelpers::HashSection(nHash, &CINI::CurrentDocument(), ID);
+	STDHelpers::HashSection(nHash, &CINI::Art(), ArtID);
+	STDHelpers::HashSection(nHash, &CINI::CurrentDocument(), ArtID);
+	return nHash;
+}
+
+ImageDataClass* CLoadingExt::TypeInfo::GetImage(int nFacing)
+{
+	// Nodes of the image map stay put until CLoading releases them
+	if (!pImages[nFacing])
+		pImages[nFacing] = ImageDataMapHelper::GetImageDataFromMap(ImageNames[nFacing]);
+	if (ObjectImageBudget::Touch(pImages[nFacing]))
+		((CLoadingExt*)CLoading::Instance())->LoadObjects(ID);
+	return pImages[nFacing];
 }
 
 CLoadingExt::ObjectType CLoadingExt::GetItemType(ppmfc::CString ID)
@@ -74,6 +154,19 @@ void CLoadingExt::LoadObjects(ppmfc::CString ID)
 
 	// GlobalVars::CMapData->UpdateCurrentDocument();
 	auto eItemType = GetItemType(ID);
+	if (eItemType == ObjectType::Unknown)
+		return;
+
+	if (ExtConfigs::ObjectImageCache)
+	{
+		if (LoadObjectsFromCache(ID))
+		{
+			RegisterToBudget(ID);
+			return;
+		}
+		ObjectImageCache::BeginRecord(ID);
+	}
+
 	switch (eItemType)
 	{
 	case CLoadingExt::ObjectType::Infantry:
@@ -94,11 +187,68 @@ void CLoadingExt::LoadObjects(ppmfc::CString ID)
 	default:
 		break;
 	}
+
+	if (ExtConfigs::ObjectImageCache)
+		ObjectImageCache::EndRecord();
+
+	RegisterToBudget(ID);
+}
+
+// Only images drawn through GetImageName can be reloaded after being evicted
+void CLoadingExt::RegisterToBudget(ppmfc::CString ID)
+{
+	if (ExtConfigs::ImageCache_MaxMB <= 0)
+		return;
+
+	auto& info = GetTypeInfo(ID);
+	if (info.Type == ObjectType::Unknown || info.Type == ObjectType::Terrain || info.Type == ObjectType::Smudge)
+		return;
+
+	for (auto& name : info.ImageNames)
+	{
+		// Facings sharing a frame, or never written, must not get empty nodes
+		if (!ImageDataMapHelper::IsImageLoaded(name))
+			continue;
+		auto pData = ImageDataMapHelper::GetImageDataFromMap(name);
+		if (pData->pImageBuffer)
+			ObjectImageBudget::Register(pData);
+	}
+}
+
+bool CLoadingExt::LoadObjectsFromCache(ppmfc::CString ID)
+{
+	std::vector<ObjectImageCache::FrameView> frames;
+	if (!ObjectImageCache::Query(ID, frames))
+		return false;
+
+	for (auto& frame : frames)
+	{
+		auto pBuffer = GameCreateArray<unsigned char>(frame.FullWidth * frame.FullHeight);
+		for (int j = 0; j < frame.ValidHeight; ++j)
+			memcpy_s(&pBuffer[(frame.ValidY + j) * frame.FullWidth + frame.ValidX], frame.ValidWidth,
+				&frame.pPixels[j * frame.ValidWidth], frame.ValidWidth);
+
+		SetImageData(pBuffer, frame.Name, frame.FullWidth, frame.FullHeight,
+			frame.PaletteName.IsEmpty() ? nullptr : PalettesManager::LoadPalette(frame.PaletteName));
+	}
+
+	return true;
 }
 
 void CLoadingExt::ClearItemTypes()
 {
+	if (!TypeInfos.empty())
+		Logger::Debug("CLoadingExt::ClearItemTypes : %u type infos served %u queries, %u rebuilt after edits.\n",
+			TypeInfos.size(), TypeInfoQueries, TypeInfoRebuilds);
+	if (VXL_FullBytes)
+		Logger::Debug("CLoadingExt::ClearItemTypes : Voxel images took %u bytes instead of %u bytes.\n", VXL_CroppedBytes, VXL_FullBytes);
+
 	ObjectTypes.clear();
+	TypeInfos.clear();
+	TypeInfoQueries = 0;
+	TypeInfoRebuilds = 0;
+	VXL_FullBytes = 0;
+	VXL_CroppedBytes = 0;
 }
 
 ppmfc::CString CLoadingExt::GetTerrainOrSmudgeFileID(ppmfc::CString ID)
@@ -186,6 +336,7 @@ void CLoadingExt::LoadBuilding(ppmfc::CString ID)
 
 		ShapeHeader header;
 		unsigned char* pBuffer;
+		ObjectImageCache::RecordSource(file);
 		CMixFile::LoadSHP(file, nMix);
 		CShpFile::GetSHPHeader(&header);
 		CShpFile::LoadFrame(nFrame, 1, &pBuffer);
@@ -215,6 +366,7 @@ void CLoadingExt::LoadBuilding(ppmfc::CString ID)
 		
 		ShapeHeader header;
 		unsigned char* pBuffer;
+		ObjectImageCache::RecordSource(file);
 		CMixFile::LoadSHP(file, nMix);
 		CShpFile::GetSHPHeader(&header);
 		CShpFile::LoadFrame(nFrame, 1, &pBuffer);
@@ -313,6 +465,8 @@ void CLoadingExt::LoadBuilding(ppmfc::CString ID)
 								break;
 						}
 
+				std::vector<unsigned char> Canvas(0x10000);
+
 				for (int i = 0; i < 8; ++i)
 				{
 					auto pTempBuf = GameCreateArray<unsigned char>(width * height);
@@ -331,7 +485,7 @@ void CLoadingExt::LoadBuilding(ppmfc::CString ID)
 						pKey.Format("%sY%d", ID, (15 - i) % 8);
 						int turdeltaY = CINI::FAData->GetInteger("BuildingVoxelTurretsRA2", pKey);
 
-						VXL_Add(pTurImages[i], turrect[i][2] + turdeltaX, turrect[i][3] + turdeltaY, turrect[i][0], turrect[i][1]);
+						VXL_Add(Canvas, pTurImages[i], turrect[i][2] + turdeltaX, turrect[i][3] + turdeltaY, turrect[i][0], turrect[i][1]);
 						delete[] pTurImages[i]; // this buffer is created inside the lib
 
 						if (pBarlImages[i])
@@ -341,15 +495,15 @@ void CLoadingExt::LoadBuilding(ppmfc::CString ID)
 							pKey.Format("%sY%d", ID, (15 - i) % 8);
 							int barldeltaY = CINI::FAData->GetInteger("BuildingVoxelBarrelsRA2", pKey);
 
-							VXL_Add(pBarlImages[i], barlrect[i][2]+ barldeltaX, barlrect[i][3]+ barldeltaY, barlrect[i][0], barlrect[i][1]);
+							VXL_Add(Canvas, pBarlImages[i], barlrect[i][2]+ barldeltaX, barlrect[i][3]+ barldeltaY, barlrect[i][0], barlrect[i][1]);
 							delete[] pBarlImages[i];
 						}
 					}
 
 					int nW = 0x100, nH = 0x100;
-					VXL_GetAndClear(pTurImages[i], &nW, &nH);
+					VXL_GetAndClear(Canvas, pTurImages[i], &nW, &nH);
 
-					UnionSHP_Add(pTurImages[i], 0x100, 0x100, deltaX, deltaY);
+					UnionSHP_Add(pTurImages[i], nW, nH, deltaX, deltaY);
 
 					unsigned char* pImage;
 					int width1, height1;
@@ -413,6 +567,7 @@ void CLoadingExt::LoadInfantry(ppmfc::CString ID)
 	{
 		ShapeHeader header;
 		unsigned char* FramesBuffers;
+		ObjectImageCache::RecordSource(FileName);
 		CMixFile::LoadSHP(FileName, nMix);
 		CShpFile::GetSHPHeader(&header);
 		for (int i = 0; i < 8; ++i)
@@ -437,6 +592,7 @@ void CLoadingExt::LoadTerrainOrSmudge(ppmfc::CString ID)
 	{
 		ShapeHeader header;
 		unsigned char* FramesBuffers[1];
+		ObjectImageCache::RecordSource(FileName);
 		CMixFile::LoadSHP(FileName, nMix);
 		CShpFile::GetSHPHeader(&header);
 		CShpFile::LoadFrame(0, 1, &FramesBuffers[0]);
@@ -480,6 +636,8 @@ void CLoadingExt::LoadVehicleOrAircraft(ppmfc::CString ID)
 						return;
 				}
 
+		std::vector<unsigned char> Canvas(0x10000);
+
 		if (bHasTurret)
 		{
 			int F, L, H;
@@ -526,7 +684,7 @@ void CLoadingExt::LoadVehicleOrAircraft(ppmfc::CString ID)
 
 				if (pImage[i])
 				{
-					VXL_Add(pImage[i], rect[i][2], rect[i][3], rect[i][0], rect[i][1]);
+					VXL_Add(Canvas, pImage[i], rect[i][2], rect[i][3], rect[i][0], rect[i][1]);
 					delete[] pImage[i];
 				}
 				ppmfc::CString pKey;
@@ -536,7 +694,7 @@ void CLoadingExt::LoadVehicleOrAircraft(ppmfc::CString ID)
 					int turdeltaX = CINI::FAData->GetInteger("VehicleVoxelTurretsRA2", pKey);
 					pKey.Format("%sY%d", ID, i);
 					int turdeltaY = CINI::FAData->GetInteger("VehicleVoxelTurretsRA2", pKey);
-					VXL_Add(pTurretImage[i], turretrect[i][2] + turdeltaX, turretrect[i][3] + turdeltaY, turretrect[i][0], turretrect[i][1]);
+					VXL_Add(Canvas, pTurretImage[i], turretrect[i][2] + turdeltaX, turretrect[i][3] + turdeltaY, turretrect[i][0], turretrect[i][1]);
 					delete[] pTurretImage[i];
 
 					if (pBarrelImage[i])
@@ -546,12 +704,12 @@ void CLoadingExt::LoadVehicleOrAircraft(ppmfc::CString ID)
 						pKey.Format("%sY%d", ID, i);
 						int barldeltaY = CINI::FAData->GetInteger("VehicleVoxelBarrelsRA2", pKey);
 
-						VXL_Add(pBarrelImage[i], barrelrect[i][2] + barldeltaX, barrelrect[i][3] + barldeltaY, barrelrect[i][0], barrelrect[i][1]);
+						VXL_Add(Canvas, pBarrelImage[i], barrelrect[i][2] + barldeltaX, barrelrect[i][3] + barldeltaY, barrelrect[i][0], barrelrect[i][1]);
 						delete[] pBarrelImage[i];
 					}
 				}
 
-				VXL_GetAndClear(outBuffer, &outW, &outH);
+				VXL_GetAndClear(Canvas, outBuffer, &outW, &outH);
 
 				SetImageData(outBuffer, DictName, outW, outH, PalettesManager::LoadPalette(PaletteName));
 			}
@@ -566,9 +724,9 @@ void CLoadingExt::LoadVehicleOrAircraft(ppmfc::CString ID)
 				unsigned char* outBuffer;
 				int outW = 0x100, outH = 0x100;
 
-				VXL_Add(pImage[i], rect[i][2], rect[i][3], rect[i][0], rect[i][1]);
+				VXL_Add(Canvas, pImage[i], rect[i][2], rect[i][3], rect[i][0], rect[i][1]);
 				delete[] pImage[i];
-				VXL_GetAndClear(outBuffer, &outW, &outH);
+				VXL_GetAndClear(Canvas, outBuffer, &outW, &outH);
 
 				SetImageData(outBuffer, DictName, outW, outH, PalettesManager::LoadPalette(PaletteName));
 			}
@@ -604,6 +762,7 @@ void CLoadingExt::LoadVehicleOrAircraft(ppmfc::CString ID)
 		{
 			ShapeHeader header;
 			unsigned char* FramesBuffers[2];
+			ObjectImageCache::RecordSource(FileName);
 			CMixFile::LoadSHP(FileName, nMix);
 			CShpFile::GetSHPHeader(&header);
 			for (int i = 0; i < 8; ++i)
@@ -643,6 +802,7 @@ void CLoadingExt::SetImageData(unsigned char* pBuffer, ppmfc::CString NameInDict
 {
 	auto pData = ImageDataMapHelper::GetImageDataFromMap(NameInDict);
 	SetImageData(pBuffer, pData, FullWidth, FullHeight, pPal);
+	ObjectImageCache::RecordFrame(NameInDict, pData, pPal);
 }
 
 void CLoadingExt::SetImageData(unsigned char* pBuffer, ImageDataClass* pData, int FullWidth, int FullHeight, Palette* pPal)
@@ -655,37 +815,23 @@ void CLoadingExt::SetImageData(unsigned char* pBuffer, ImageDataClass* pData, in
 	pData->pImageBuffer = pBuffer;
 	pData->FullHeight = FullHeight;
 	pData->FullWidth = FullWidth;
-	SetValidBuffer(pData, FullWidth, FullHeight);
-
-	// Get available area
-	int counter = 0;
-	int validFirstX = FullWidth - 1;
-	int validFirstY = FullHeight - 1;
-	int validLastX = 0;
-	int validLastY = 0;
-	for (int j = 0; j < FullHeight; ++j)
+
+	// Get available area and valid range of each row in a single pass
+	std::vector<int> firsts(FullHeight), lasts(FullHeight);
+	ImageScanner::Bounds bounds{ FullWidth - 1, FullHeight - 1, 0, 0 };
+	ImageScanner::Scan(pBuffer, FullWidth, FullHeight, bounds, firsts.data(), lasts.data());
+
+	pData->pPixelValidRanges = GameCreateArray<ImageDataClass::ValidRangeData>(FullHeight);
+	for (int i = 0; i < FullHeight; ++i)
 	{
-		for (int i = 0; i < FullWidth; ++i)
-		{
-			unsigned char ch = pBuffer[counter++];
-			if (ch != 0)
-			{
-				if (i < validFirstX)
-					validFirstX = i;
-				if (j < validFirstY)
-					validFirstY = j;
-				if (i > validLastX)
-					validLastX = i;
-				if (j > validLastY)
-					validLastY = j;
-			}
-		}
+		pData->pPixelValidRanges[i].First = firsts[i];
+		pData->pPixelValidRanges[i].Last = lasts[i];
 	}
 
-	pData->ValidX = validFirstX;
-	pData->ValidY = validFirstY;
-	pData->ValidWidth = validLastX - validFirstX + 1;
-	pData->ValidHeight = validLastY - validFirstY + 1;
+	pData->ValidX = bounds.FirstX;
+	pData->ValidY = bounds.FirstY;
+	pData->ValidWidth = bounds.LastX - bounds.FirstX + 1;
+	pData->ValidHeight = bounds.LastY - bounds.FirstY + 1;
 
 	pData->Flag = ImageDataFlag::SHP;
 	pData->IsOverlay = false;
@@ -695,31 +841,13 @@ void CLoadingExt::SetImageData(unsigned char* pBuffer, ImageDataClass* pData, in
 // Also will delete the origin buffer and create a new buffer.
 void CLoadingExt::ShrinkSHP(unsigned char* pIn, int InWidth, int InHeight, unsigned char*& pOut, int* OutWidth, int* OutHeight)
 {
-	int counter = 0;
-	int validFirstX = InWidth - 1;
-	int validFirstY = InHeight - 1;
-	int validLastX = 0;
-	int validLastY = 0;
-	for (int j = 0; j < InHeight; ++j)
-	{
-		for (int i = 0; i < InWidth; ++i)
-		{
-			unsigned char ch = pIn[counter++];
-			if (ch != 0)
-			{
-				if (i < validFirstX)
-					validFirstX = i;
-				if (j < validFirstY)
-					validFirstY = j;
-				if (i > validLastX)
-					validLastX = i;
-				if (j > validLastY)
-					validLastY = j;
-			}
-		}
-	}
+	ImageScanner::Bounds bounds{ InWidth - 1, InHeight - 1, 0, 0 };
+	ImageScanner::Scan(pIn, InWidth, InHeight, bounds);
+	int validFirstX = bounds.FirstX;
+	int validFirstY = bounds.FirstY;
+	int validLastX = bounds.LastX;
+	int validLastY = bounds.LastY;
 
-	counter = 0;
 	*OutWidth = validLastX - validFirstX + 1;
 	*OutHeight = validLastY - validFirstY + 1;
 	pOut = GameCreateArray<unsigned char>(*OutWidth * *OutHeight);
@@ -781,56 +909,39 @@ void CLoadingExt::UnionSHP_GetAndClear(unsigned char*& pOutBuffer, int* OutWidth
 	UnionSHP_Data[UseTemp].clear();
 }
 
-void CLoadingExt::VXL_Add(unsigned char* pCache, int X, int Y, int Width, int Height)
+void CLoadingExt::VXL_Add(std::vector<unsigned char>& Canvas, unsigned char* pCache, int X, int Y, int Width, int Height)
 {
 	for (int j = 0; j < Height; ++j)
 		for (int i = 0; i < Width; ++i)
 			if (auto ch = pCache[j * Width + i])
-				VXL_Data[(j + Y) * 0x100 + X + i] = ch;
+				Canvas[(j + Y) * 0x100 + X + i] = ch;
 }
 
-void CLoadingExt::VXL_GetAndClear(unsigned char*& pBuffer, int* OutWidth, int* OutHeight)
+// The result is cropped symmetrically around the canvas center,
+// so the image is still drawn at the same place as the full 0x100 * 0x100 one.
+void CLoadingExt::VXL_GetAndClear(std::vector<unsigned char>& Canvas, unsigned char*& pBuffer, int* OutWidth, int* OutHeight)
 {
-	/* TODO : Save memory
-	int validFirstX = 0x100 - 1;
-	int validFirstY = 0x100 - 1;
-	int validLastX = 0;
-	int validLastY = 0;
-
-	for (int j = 0; j < 0x100; ++j)
+	ImageScanner::Bounds bounds;
+	int W = 0x100, H = 0x100;
+	if (ImageScanner::Scan(Canvas.data(), 0x100, 0x100, bounds))
 	{
-		for (int i = 0; i < 0x100; ++i)
-		{
-			unsigned char ch = VXL_Data[j * 0x100 + i];
-			if (ch != 0)
-			{
-				if (i < validFirstX)
-					validFirstX = i;
-				if (j < validFirstY)
-					validFirstY = j;
-				if (i > validLastX)
-					validLastX = i;
-				if (j > validLastY)
-					validLastY = j;
-			}
-		}
+		W = 2 * std::max(0x80 - bounds.FirstX, bounds.LastX + 1 - 0x80);
+		H = 2 * std::max(0x80 - bounds.FirstY, bounds.LastY + 1 - 0x80);
 	}
-	*/
-	pBuffer = GameCreateArray<unsigned char>(0x10000);
-	memcpy_s(pBuffer, 0x10000, VXL_Data, 0x10000);
-	memset(VXL_Data, 0, 0x10000);
-}
 
-void CLoadingExt::SetValidBuffer(ImageDataClass* pData, int Width, int Height)
-{
-	pData->pPixelValidRanges = GameCreateArray<ImageDataClass::ValidRangeData>(Height);
-	for (int i = 0; i < Height; ++i)
-	{
-		int begin, end;
-		this->GetSHPValidRange(pData->pImageBuffer, Width, i, &begin, &end);
-		pData->pPixelValidRanges[i].First = begin;
-		pData->pPixelValidRanges[i].Last = end;
-	}
+	int nStartX = 0x80 - W / 2;
+	int nStartY = 0x80 - H / 2;
+
+	pBuffer = GameCreateArray<unsigned char>(W * H);
+	for (int j = 0; j < H; ++j)
+		memcpy_s(&pBuffer[j * W], W, &Canvas[(nStartY + j) * 0x100 + nStartX], W);
+	std::fill(Canvas.begin(), Canvas.end(), 0);
+
+	*OutWidth = W;
+	*OutHeight = H;
+
+	VXL_FullBytes += 0x10000;
+	VXL_CroppedBytes += W * H;
 }
 
 void CLoadingExt::GetFullPaletteName(ppmfc::CString& PaletteName)
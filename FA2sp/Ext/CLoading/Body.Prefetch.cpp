@@ -0,0 +1,129 @@
+#include "Body.h"
+
+#include <CINI.h>
+#include <CMapData.h>
+#include <CFinalSunDlg.h>
+#include <Drawing.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <tuple>
+
+#include "../../Helpers/STDHelpers.h"
+#include "../../Helpers/Translations.h"
+#include "../../FA2sp.h"
+
+bool CLoadingExt::IsObjectLoaded(ppmfc::CString ID, ObjectType eItemType)
+{
+	if (eItemType == ObjectType::Terrain || eItemType == ObjectType::Smudge)
+		return ImageDataMapHelper::IsImageLoaded(GetTerrainOrSmudgeFileID(ID) + "0");
+	return ImageDataMapHelper::IsImageLoaded(GetTypeInfo(ID).ImageNames[0]);
+}
+
+// The file LoadObjects reads first, only used to order the prefetch
+ppmfc::CString CLoadingExt::GetPrimaryFileName(ppmfc::CString ID, ObjectType eItemType)
+{
+	switch (eItemType)
+	{
+	case ObjectType::Infantry:
+		return GetInfantryFileID(ID) + ".SHP";
+	case ObjectType::Vehicle:
+	case ObjectType::Aircraft:
+		if (CINI::Art->GetBool(GetArtID(ID), "Voxel"))
+			return GetVehicleOrAircraftFileID(ID) + ".VXL";
+		return GetVehicleOrAircraftFileID(ID) + ".SHP";
+	case ObjectType::Building:
+		return GetBuildingFileID(ID) + ".SHP";
+	case ObjectType::Terrain:
+	case ObjectType::Smudge:
+		return GetTerrainOrSmudgeFileID(ID) + this->GetFileExtension();
+	default:
+		return "";
+	}
+}
+
+void CLoadingExt::PrefetchMapObjects()
+{
+	auto pINI = CMapData::GetMapDocument(true);
+	if (!pINI)
+		return;
+
+	CLoadingExt* pLoading = (CLoadingExt*)CLoading::Instance();
+	auto begin = std::chrono::steady_clock::now();
+
+	// section, index of the type id in values (-1 for the value itself)
+	const std::pair<const char*, int> Sections[] =
+	{
+		{"Structures", 1},
+		{"Infantry", 1},
+		{"Units", 1},
+		{"Aircraft", 1},
+		{"Terrain", -1},
+	};
+
+	std::set<ppmfc::CString> IDs;
+	size_t nCounts[_countof(Sections)] = { 0 };
+	for (size_t i = 0; i < _countof(Sections); ++i)
+	{
+		auto pSection = pINI->GetSection(Sections[i].first);
+		if (!pSection)
+			continue;
+
+		for (auto& pair : pSection->GetEntities())
+		{
+			ppmfc::CString ID;
+			if (Sections[i].second < 0)
+				ID = pair.second;
+			else
+			{
+				auto splits = STDHelpers::SplitString(pair.second, Sections[i].second);
+				if (splits.size() <= static_cast<size_t>(Sections[i].second))
+					continue;
+				ID = splits[Sections[i].second];
+			}
+			ID.Trim();
+			if (IDs.insert(ID).second)
+				++nCounts[i];
+		}
+	}
+
+	// FA2's mix and shp readers are not thread safe, so instead of loading in parallel
+	// we load in mix order and keep each mix's entries together
+	std::vector<std::tuple<int, ppmfc::CString, ppmfc::CString>> Queue;
+	size_t nSkipped = 0;
+	for (auto& ID : IDs)
+	{
+		auto eItemType = pLoading->GetItemType(ID);
+		if (eItemType == ObjectType::Unknown || pLoading->IsObjectLoaded(ID, eItemType))
+		{
+			++nSkipped;
+			continue;
+		}
+		auto FileName = pLoading->GetPrimaryFileName(ID, eItemType);
+		Queue.emplace_back(pLoading->SearchFile(FileName), FileName, ID);
+	}
+	std::sort(Queue.begin(), Queue.end());
+
+	auto& StatusBar = CFinalSunDlg::Instance->MyViewFrame.StatusBar;
+	ppmfc::CString label, buffer;
+	if (!Translations::GetTranslationItem("LoadingObjects", label))
+		label = "Loading objects...";
+	for (size_t i = 0; i < Queue.size(); ++i)
+	{
+		if (i % 16 == 0)
+		{
+			buffer.Format("%s %u/%u", label, i, Queue.size());
+			StatusBar.SetWindowText(buffer);
+			StatusBar.UpdateWindow();
+		}
+		pLoading->LoadObjects(std::get<2>(Queue[i]));
+	}
+	StatusBar.SetWindowText("");
+	StatusBar.UpdateWindow();
+
+	auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+	Logger::Debug("CLoadingExt::PrefetchMapObjects : %u objects loaded in %d ms, %u skipped. "
+		"Structures %u, Infantry %u, Units %u, Aircraft %u, Terrain %u.\n",
+		Queue.size(), static_cast<int>(time), nSkipped, nCounts[0], nCounts[1], nCounts[2], nCounts[3], nCounts[4]);
+}
@@ -21,9 +21,39 @@ public:
 	CLoadingExt() {};
 	~CLoadingExt() {};
 
+	enum class ObjectType{
+		Unknown = -1,
+		Infantry = 0,
+		Vehicle = 1,
+		Aircraft = 2,
+		Building = 3,
+		Terrain = 4,
+		Smudge = 5
+	};
+
+	// Everything the draw hooks need about a type, resolved once per map
+	struct TypeInfo
+	{
+		ppmfc::CString ID;
+		ObjectType Type;
+		ppmfc::CString ArtID;
+		ppmfc::CString ImageNames[8];
+		ImageDataClass* pImages[8];
+		bool HasTurret;
+		int PowerUpLocs[3][2]; // PowerUp1LocXX/YY ~ PowerUp3LocXX/YY
+		unsigned int SectionHash; // of the sections the fields above were read from
+		unsigned int CheckedVersion; // document version SectionHash was last compared at
+
+		ImageDataClass* GetImage(int nFacing);
+	};
+
 	void LoadObjects(ppmfc::CString pRegName);
 	static ppmfc::CString GetImageName(ppmfc::CString ID, int nFacing);
+	static TypeInfo& GetTypeInfo(ppmfc::CString ID);
 	static void ClearItemTypes();
+	static bool HasTypeInfos() { return !TypeInfos.empty(); }
+	// Loads every object type placed on the current map in one pass
+	static void PrefetchMapObjects();
 private:
 	void GetFullPaletteName(ppmfc::CString& PaletteName);
 	static ppmfc::CString* __cdecl GetDictName(ppmfc::CString* ret, const char* ID, int nFacing) { JMP_STD(0x475450); }
@@ -34,6 +64,10 @@ private:
 		return buffer;
 	}
 
+	bool IsObjectLoaded(ppmfc::CString ID, ObjectType eItemType);
+	ppmfc::CString GetPrimaryFileName(ppmfc::CString ID, ObjectType eItemType);
+	bool LoadObjectsFromCache(ppmfc::CString ID);
+	static void RegisterToBudget(ppmfc::CString ID);
 	void LoadBuilding(ppmfc::CString ID);
 	void LoadInfantry(ppmfc::CString ID);
 	void LoadTerrainOrSmudge(ppmfc::CString ID);
@@ -44,20 +78,9 @@ private:
 	void ShrinkSHP(unsigned char* pIn, int InWidth, int InHeight, unsigned char*& pOut, int* OutWidth, int* OutHeight);
 	void UnionSHP_Add(unsigned char* pBuffer, int Width, int Height, int DeltaX = 0, int DeltaY = 0, bool UseTemp = false);
 	void UnionSHP_GetAndClear(unsigned char*& pOutBuffer, int* OutWidth, int* OutHeight, bool UseTemp = false);
-	void VXL_Add(unsigned char* pCache, int X, int Y, int Width, int Height);
-	void VXL_GetAndClear(unsigned char*& pBuffer, int* OutWidth, int* OutHeight);
-	
-	void SetValidBuffer(ImageDataClass* pData, int Width, int Height);
-
-	enum class ObjectType{
-		Unknown = -1,
-		Infantry = 0,
-		Vehicle = 1,
-		Aircraft = 2,
-		Building = 3,
-		Terrain = 4,
-		Smudge = 5
-	};
+	// Canvas is a 0x100 * 0x100 scratch owned by the caller
+	void VXL_Add(std::vector<unsigned char>& Canvas, unsigned char* pCache, int X, int Y, int Width, int Height);
+	void VXL_GetAndClear(std::vector<unsigned char>& Canvas, unsigned char*& pBuffer, int* OutWidth, int* OutHeight);
 
 	ppmfc::CString GetArtID(ppmfc::CString ID);
 	ppmfc::CString GetVehicleOrAircraftFileID(ppmfc::CString ID);
@@ -79,5 +102,10 @@ private:
 	
 	static std::vector<SHPUnionData> UnionSHP_Data[2];
 	static std::map<ppmfc::CString, ObjectType> ObjectTypes;
-	static unsigned char VXL_Data[0x10000];
+	static std::map<ppmfc::CString, TypeInfo> TypeInfos;
+	static size_t TypeInfoQueries;
+	static size_t TypeInfoRebuilds;
+	static unsigned int GetTypeSectionHash(ppmfc::CString ID, ppmfc::CString ArtID);
+	static size_t VXL_FullBytes;
+	static size_t VXL_CroppedBytes;
 };
\ No newline at end of file
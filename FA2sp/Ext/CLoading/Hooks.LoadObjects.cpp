@@ -3,18 +3,28 @@
 #include <Helpers/Macro.h>
 
 #include <CObjectDatas.h>
+#include <CMapData.h>
 #include <CINI.h>
 #include <Drawing.h>
 
 #include "../../FA2sp.h"
-
+#include "../../Miscs/DocumentVersion.h"
+#include "../../Miscs/MarkerIndex.h"
+#include "../../Miscs/ObjectImageBudget.h"
+#include "../../Miscs/ObjectImageCache.h"
+#include "../../Miscs/RedrawScheduler.h"
+#include "../../Miscs/ObjectLoadQueue.h"
+#include "../../Miscs/TypeClassification.h"
 
 DEFINE_HOOK(4808A0, CLoading_LoadObjects, 5)
 {
     GET(CLoadingExt*, pThis, ECX);
     REF_STACK(ppmfc::CString, pRegName, 0x4);
 
-    pThis->CLoadingExt::LoadObjects(pRegName);
+    if (ExtConfigs::DeferObjectLoading && ObjectLoadQueue::IsDrawing)
+        ObjectLoadQueue::Push(pRegName);
+    else
+        pThis->CLoadingExt::LoadObjects(pRegName);
 
     return 0x486173;
 }
@@ -62,12 +72,36 @@ DEFINE_HOOK(4716BB, CLoading_Draw_PowerUpFacingFix, 7)
 DEFINE_HOOK(42CBFC, CFinalSunDlg_CreateMap_ClearCLoadingExtData, 8)
 {
     CLoadingExt::ClearItemTypes();
+    ObjectImageBudget::Clear();
+    ObjectLoadQueue::Clear();
+    MarkerIndex::Clear();
+    RedrawScheduler::Clear();
+    TypeClassification::Clear();
+    ObjectImageCache::ClearHashes();
+    DocumentVersion::Bump();
     return 0;
 }
 
 DEFINE_HOOK(49D2C0, CMapData_LoadMap_ClearCLoadingExtData, 5)
 {
     CLoadingExt::ClearItemTypes();
+    ObjectImageBudget::Clear();
+    ObjectLoadQueue::Clear();
+    MarkerIndex::Clear();
+    RedrawScheduler::Clear();
+    TypeClassification::Clear();
+    ObjectImageCache::ClearHashes();
+    DocumentVersion::Bump();
+    return 0;
+}
+
+DEFINE_HOOK(438D90, CFinalSunDlg_LoadMap_PrefetchObjects, 7)
+{
+    // The map was read into the document since it was cleared
+    DocumentVersion::Bump();
+
+    if (ExtConfigs::PrefetchObjects && CMapData::Instance->MapWidthPlusHeight)
+        CLoadingExt::PrefetchMapObjects();
     return 0;
 }
 
@@ -75,7 +109,13 @@ DEFINE_HOOK(491FD4, CLoading_Release_SetImageDataToNullptr, 5)
 {
     GET(char*, pNode, ESI); // Map node in fact
     ImageDataClass* pData = (ImageDataClass*)(pNode + 0xC + 0x4); // data = pNode->_Value.second
-    
+
+    // The budget is emptied when the map is cleared, ahead of the release, and only
+    // drops this node here. Type infos are normally gone by then as well.
+    ObjectImageBudget::Forget(pData);
+    if (CLoadingExt::HasTypeInfos())
+        CLoadingExt::ClearItemTypes();
+
     if (pData->pImageBuffer)
     {
         GameDelete(pData->pImageBuffer);
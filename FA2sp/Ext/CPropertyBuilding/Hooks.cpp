@@ -8,6 +8,7 @@
 #include "../../FA2sp.h"
 
 #include "../CFinalSunDlg/Body.h"
+#include "../../Miscs/TypeClassification.h"
 
 // FA2 Building Property window is fucked
 DEFINE_HOOK(417F40, CPropertyBuilding_OnInitDialog, 7)
@@ -67,7 +68,7 @@ DEFINE_HOOK(417F40, CPropertyBuilding_OnInitDialog, 7)
 
                 for (const auto& upgrade : upgrades)
                 {
-                    const auto UIName = CMapData::Instance->GetUIName(upgrade.c_str());
+                    const auto UIName = TypeClassification::GetUIName(upgrade.c_str());
                     const auto name = std::format("{} ({})", upgrade, UIName);
 
                     for (int i = 0; i < nUpgrades; ++i)
@@ -2,9 +2,15 @@
 #include "FA2sp.Constants.h"
 
 #include "Helpers/MutexHelper.h"
+#include "Helpers/Translations.h"
 #include "Miscs/Palettes.h"
 #include "Miscs/DrawStuff.h"
 #include "Miscs/Exception.h"
+#include "Miscs/MixFileView.h"
+#include "Miscs/MixIndex.h"
+#include "Miscs/ObjectImageCache.h"
+#include "Miscs/RedrawScheduler.h"
+#include "Miscs/SaveMap.h"
 
 #include <CINI.h>
 
@@ -13,7 +19,7 @@
 HANDLE FA2sp::hInstance;
 std::string FA2sp::STDBuffer;
 ppmfc::CString FA2sp::Buffer;
-std::map<ppmfc::CString, ppmfc::CString> FA2sp::TutorialTextsMap;
+CSFTable FA2sp::TutorialTexts;
 void* FA2sp::pExceptionHandler = nullptr;
 
 bool ExtConfigs::BrowserRedraw;
@@ -44,6 +50,10 @@ int ExtConfigs::SaveMap_AutoSave_MaxCount;
 bool ExtConfigs::SaveMap_OnlySaveMAP;
 bool ExtConfigs::VerticalLayout;
 bool ExtConfigs::FastResize;
+bool ExtConfigs::ObjectImageCache;
+bool ExtConfigs::DeferObjectLoading;
+int ExtConfigs::ImageCache_MaxMB;
+bool ExtConfigs::PrefetchObjects;
 
 MultimapHelper Variables::Rules = { &CINI::Rules(), &CINI::CurrentDocument() };
 
@@ -108,6 +118,14 @@ void FA2sp::ExtConfigsInitialize()
 	ExtConfigs::VerticalLayout = fadata.GetBool("ExtConfigs", "VerticalLayout");
 
 	ExtConfigs::FastResize = fadata.GetBool("ExtConfigs", "FastResize");
+
+	ExtConfigs::ObjectImageCache = fadata.GetBool("ExtConfigs", "ObjectImageCache");
+
+	ExtConfigs::DeferObjectLoading = fadata.GetBool("ExtConfigs", "DeferObjectLoading");
+
+	ExtConfigs::ImageCache_MaxMB = fadata.GetInteger("ExtConfigs", "ImageCache.MaxMB", 0);
+
+	ExtConfigs::PrefetchObjects = fadata.GetBool("ExtConfigs", "PrefetchObjects", false);
 }
 
 // DllMain
@@ -222,6 +240,13 @@ DEFINE_HOOK(47FACE, CLoading_OnInitDialog_ProgramInfo, 7)
 DEFINE_HOOK(537208, ExeTerminate, 9)
 {
 	MutexHelper::Detach();
+	SaveMapExt::StopTimer();
+	SaveMapExt::JoinAutoSaveThread();
+	ObjectImageCache::Close();
+	MixIndex::LogStats();
+	MixFileView::LogStats();
+	RedrawScheduler::LogStats();
+	Translations::LogStats();
 	Logger::Info("FA2sp Terminating...\n");
 	Logger::Close();
 	DrawStuff::deinit();
@@ -3,6 +3,7 @@
 #include "Logger.h"
 #include "Ext/FA2Expand.h"
 #include "Helpers/MultimapHelper.h"
+#include "Helpers/CSFTable.h"
 
 #include <Helpers/Macro.h>
 #include <MFC/ppmfc_cstring.h>
@@ -17,7 +18,7 @@ public:
     static HANDLE hInstance;
     static std::string STDBuffer;
     static ppmfc::CString Buffer;
-    static std::map<ppmfc::CString, ppmfc::CString> TutorialTextsMap;
+    static CSFTable TutorialTexts;
     static void* pExceptionHandler;
 
     static void ExtConfigsInitialize();
@@ -54,6 +55,10 @@ public:
     static bool SaveMap_OnlySaveMAP;
     static bool VerticalLayout;
     static bool FastResize;
+    static bool ObjectImageCache;
+    static bool DeferObjectLoading;
+    static int ImageCache_MaxMB;
+    static bool PrefetchObjects;
 };
 
 class Variables
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+
+// Standard CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320)
+// Calls can be chained: Compute(b, nb, Compute(a, na)) == Compute(a + b, na + nb)
+
+class CRC32
+{
+public:
+    static unsigned int Compute(const void* pData, size_t nLength, unsigned int nCRC = 0)
+    {
+        auto p = static_cast<const unsigned char*>(pData);
+        nCRC = ~nCRC;
+        while (nLength--)
+            nCRC = Table[(nCRC ^ *p++) & 0xFF] ^ (nCRC >> 8);
+        return ~nCRC;
+    }
+
+    static unsigned int ComputeString(const char* pString, unsigned int nCRC = 0)
+    {
+        return Compute(pString, strlen(pString), nCRC);
+    }
+
+private:
+    static const std::array<unsigned int, 256> Table;
+};
+
+// Built outside the class, the table initializer can't call members of a class still being defined
+inline constexpr std::array<unsigned int, 256> MakeCRC32Table()
+{
+    std::array<unsigned int, 256> ret{};
+    for (unsigned int i = 0; i < 256; ++i)
+    {
+        unsigned int c = i;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        ret[i] = c;
+    }
+    return ret;
+}
+
+inline const std::array<unsigned int, 256> CRC32::Table = MakeCRC32Table();
@@ -0,0 +1,298 @@
+#include "CSFTable.h"
+#include "STDHelpers.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    int ReadInt(const char* p)
+    {
+        int n;
+        memcpy(&n, p, 4);
+        return n;
+    }
+
+    void WriteInt(char*& p, int n)
+    {
+        memcpy(p, &n, 4);
+        p += 4;
+    }
+
+    // ASCII only, the same as tolower in the C locale
+    char ToLower(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    }
+
+    size_t HashLabel(std::string_view Label)
+    {
+        unsigned int nHash = STDHelpers::FNVOffsetBasis32;
+        STDHelpers::HashString(nHash, Label.data(), Label.length(), true);
+        return nHash;
+    }
+
+    // Stored labels are lowercase already
+    bool LabelEquals(std::string_view Stored, std::string_view Label)
+    {
+        if (Stored.length() != Label.length())
+            return false;
+        for (size_t i = 0; i < Label.length(); ++i)
+            if (Stored[i] != ToLower(Label[i]))
+                return false;
+        return true;
+    }
+}
+
+bool CSFTable::Parse(const char* pData, size_t nSize)
+{
+    if (nSize < 24 || memcmp(pData, " FSC", 4) != 0)
+        return false;
+
+    if (!TextBuffer.empty())
+    {
+        for (auto& entry : Entries)
+            entry.Text = {};
+        TextBuffer.clear();
+    }
+
+    int nLabels = ReadInt(pData + 8);
+    if (nLabels <= 0)
+        return true;
+    // Every label takes 12 bytes at least, don't trust the header beyond that
+    Reserve(Entries.size() + std::min<size_t>(nLabels, nSize / 12));
+
+    // What is kept of a label is never larger than its bytes in the file, so one block of
+    // the file size holds them all. Values go from the front, all of them are an even
+    // number of bytes so they stay aligned, labels from the back.
+    Chunks.emplace_back(new char[nSize]);
+    ArenaSize += nSize;
+    auto pValues = reinterpret_cast<char16_t*>(Chunks.back().get());
+    auto pLabels = Chunks.back().get() + nSize;
+
+    const char* pos = pData + 24;
+    const char* const end = pData + nSize;
+    for (int i = 0; i < nLabels; ++i)
+    {
+        if (end - pos < 12 || memcmp(pos, " LBL", 4) != 0)
+            break;
+        int nPairs = ReadInt(pos + 4);
+        int nLength = ReadInt(pos + 8);
+        pos += 12;
+        if (nLength < 0 || end - pos < nLength)
+            break;
+
+        pLabels -= nLength;
+        for (int k = 0; k < nLength; ++k)
+            pLabels[k] = ToLower(pos[k]);
+        std::string_view Label{ pLabels, static_cast<size_t>(nLength) };
+        pos += nLength;
+
+        // Extra strings of a label are skipped, FA2 only uses the first one
+        std::u16string_view Value;
+        bool bTruncated = false;
+        for (int j = 0; j < nPairs; ++j)
+        {
+            if (end - pos < 8)
+            {
+                bTruncated = true;
+                break;
+            }
+            bool bExtra = memcmp(pos, "WRTS", 4) == 0;
+            int nValueLength = ReadInt(pos + 4);
+            pos += 8;
+            if (nValueLength < 0 || (end - pos) / 2 < nValueLength)
+            {
+                bTruncated = true;
+                break;
+            }
+
+            if (j == 0)
+            {
+                auto p = reinterpret_cast<const unsigned char*>(pos);
+                for (int k = 0; k < nValueLength; ++k)
+                    pValues[k] = static_cast<char16_t>(~(p[k * 2] | p[k * 2 + 1] << 8));
+                Value = { pValues, static_cast<size_t>(nValueLength) };
+                pValues += nValueLength;
+            }
+            pos += nValueLength * 2;
+
+            if (bExtra)
+            {
+                int nExtraLength = end - pos < 4 ? -1 : ReadInt(pos);
+                pos += 4;
+                if (nExtraLength < 0 || end - pos < nExtraLength)
+                {
+                    bTruncated = true;
+                    break;
+                }
+                pos += nExtraLength;
+            }
+        }
+        if (bTruncated && Value.data() == nullptr)
+            break;
+
+        size_t nHash = HashLabel(Label);
+        size_t nSlot = FindSlot(Label, nHash);
+        if (Slots[nSlot])
+            Entries[Slots[nSlot] - 1].Value = Value;
+        else
+        {
+            if ((Entries.size() + 1) * 2 > Slots.size())
+            {
+                Reserve(Entries.size() + 1);
+                nSlot = FindSlot(Label, nHash);
+            }
+            Entries.push_back({ Label, Value, {} });
+            Slots[nSlot] = static_cast<unsigned int>(Entries.size());
+        }
+
+        if (bTruncated)
+            break;
+    }
+
+    return true;
+}
+
+const CSFTable::Entry* CSFTable::Find(std::string_view Label) const
+{
+    if (Slots.empty())
+        return nullptr;
+    if (auto nIndex = Slots[FindSlot(Label, HashLabel(Label))])
+        return &Entries[nIndex - 1];
+    return nullptr;
+}
+
+void CSFTable::Clear()
+{
+    Entries.clear();
+    Entries.shrink_to_fit();
+    Slots.clear();
+    Slots.shrink_to_fit();
+    Chunks.clear();
+    ArenaSize = 0;
+    TextBuffer.clear();
+    TextBuffer.shrink_to_fit();
+}
+
+std::vector<const CSFTable::Entry*> CSFTable::GetSorted() const
+{
+    std::vector<const Entry*> ret;
+    ret.reserve(Entries.size());
+    for (auto& entry : Entries)
+        ret.push_back(&entry);
+    std::sort(ret.begin(), ret.end(), [](const Entry* a, const Entry* b) { return a->Label < b->Label; });
+    return ret;
+}
+
+size_t CSFTable::GetImageSize() const
+{
+    // Header, then " LBL", string count, label length, label, " RTS", value length and value per label
+    size_t nSize = 24;
+    for (auto& entry : Entries)
+        nSize += 24 + entry.Label.length() + entry.Value.length() * 2;
+    return nSize;
+}
+
+void CSFTable::WriteImage(char* pDest) const
+{
+    char* pos = pDest;
+    auto nCount = static_cast<int>(Entries.size());
+
+    memcpy(pos, " FSC", 4);
+    pos += 4;
+    WriteInt(pos, 3);
+    WriteInt(pos, nCount);
+    WriteInt(pos, nCount);
+    memcpy(pos, "LMAO", 4); // useless
+    pos += 4;
+    WriteInt(pos, 0);
+
+    for (auto pEntry : GetSorted())
+    {
+        memcpy(pos, " LBL", 4);
+        pos += 4;
+        WriteInt(pos, 1);
+        WriteInt(pos, static_cast<int>(pEntry->Label.length()));
+        memcpy(pos, pEntry->Label.data(), pEntry->Label.length());
+        pos += pEntry->Label.length();
+
+        memcpy(pos, " RTS", 4);
+        pos += 4;
+        WriteInt(pos, static_cast<int>(pEntry->Value.length()));
+        for (char16_t c : pEntry->Value)
+        {
+            *pos++ = static_cast<char>(~c & 0xFF);
+            *pos++ = static_cast<char>(~c >> 8 & 0xFF);
+        }
+    }
+}
+
+std::u16string CSFTable::JoinValues() const
+{
+    size_t nLength = 0;
+    for (auto& entry : Entries)
+        nLength += entry.Value.length() + 1;
+
+    std::u16string ret;
+    ret.reserve(nLength);
+    for (auto& entry : Entries)
+    {
+        // Texts end at the first null character like they did as CStrings
+        ret.append(entry.Value.substr(0, entry.Value.find(u'\0')));
+        ret.push_back(u'\0');
+    }
+    return ret;
+}
+
+bool CSFTable::SetTexts(std::string Texts)
+{
+    TextBuffer = std::move(Texts);
+    std::string_view texts{ TextBuffer };
+
+    size_t nPos = 0;
+    for (auto& entry : Entries)
+    {
+        auto nEnd = texts.find('\0', nPos);
+        if (nEnd == std::string_view::npos)
+        {
+            for (auto& another : Entries)
+                another.Text = {};
+            TextBuffer.clear();
+            return false;
+        }
+        entry.Text = texts.substr(nPos, nEnd - nPos);
+        nPos = nEnd + 1;
+    }
+    return true;
+}
+
+void CSFTable::Reserve(size_t nCount)
+{
+    if (nCount * 2 <= Slots.size())
+        return;
+
+    size_t nSlots = 64;
+    while (nSlots < nCount * 2)
+        nSlots <<= 1;
+
+    Slots.assign(nSlots, 0);
+    size_t nMask = nSlots - 1;
+    for (size_t i = 0; i < Entries.size(); ++i)
+    {
+        size_t nSlot = HashLabel(Entries[i].Label) & nMask;
+        while (Slots[nSlot])
+            nSlot = (nSlot + 1) & nMask;
+        Slots[nSlot] = static_cast<unsigned int>(i + 1);
+    }
+    Entries.reserve(nCount);
+}
+
+size_t CSFTable::FindSlot(std::string_view Label, size_t nHash) const
+{
+    size_t nMask = Slots.size() - 1;
+    size_t nSlot = nHash & nMask;
+    while (Slots[nSlot] && !LabelEquals(Entries[Slots[nSlot] - 1].Label, Label))
+        nSlot = (nSlot + 1) & nMask;
+    return nSlot;
+}
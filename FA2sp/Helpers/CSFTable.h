@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Labels of one or more csf files merged into one table, only depends on the standard library
+//
+// Labels (lowercased, csf labels aren't case sensitive) and decoded UTF-16 values are
+// copied into an arena block sized from each file, entries only hold views into it.
+// Lookup goes through an open addressing hash table of entry indices.
+// Later files override the values of labels already in the table.
+class CSFTable
+{
+public:
+    struct Entry
+    {
+        std::string_view Label;
+        std::u16string_view Value;
+        std::string_view Text; // Value in the local code page, only set by SetTexts
+    };
+
+    // Returns false if the data isn't a csf file, truncated files keep the labels read so far
+    bool Parse(const char* pData, size_t nSize);
+    const Entry* Find(std::string_view Label) const;
+    void Clear();
+
+    size_t Size() const { return Entries.size(); }
+    size_t GetArenaSize() const { return ArenaSize; }
+    // In the order the labels were first added
+    const std::vector<Entry>& GetEntries() const { return Entries; }
+    // Ordered by label
+    std::vector<const Entry*> GetSorted() const;
+
+    // The merged table as a csf file, labels ordered and one string per label
+    size_t GetImageSize() const;
+    void WriteImage(char* pDest) const;
+
+    // All values up to their first null character, each followed by one, for a single
+    // conversion call. SetTexts takes the converted result and splits it back to the entries.
+    std::u16string JoinValues() const;
+    bool SetTexts(std::string Texts);
+
+private:
+    void Reserve(size_t nCount);
+    size_t FindSlot(std::string_view Label, size_t nHash) const;
+
+    std::vector<Entry> Entries;
+    std::vector<unsigned int> Slots; // entry index + 1, 0 for empty slots
+    std::vector<std::unique_ptr<char[]>> Chunks; // one per parsed file
+    size_t ArenaSize = 0;
+    std::string TextBuffer;
+};
@@ -4,6 +4,7 @@
 #include "MultimapHelper.h"
 
 #include "../FA2sp.h"
+#include "../Miscs/TypeClassification.h"
 
 #include <CMapData.h>
 
@@ -84,9 +85,9 @@ namespace ControlHelpers
             if (!bRegNameFirst)
             {
                 if (bShowIndex)
-                    buffer.Format("%u - %s", i, CMapData::GetUIName(entries[i]));
+                    buffer.Format("%u - %s", i, TypeClassification::GetUIName(entries[i]));
                 else
-                    buffer = CMapData::GetUIName(entries[i]);
+                    buffer = TypeClassification::GetUIName(entries[i]);
             }
             else
             {
@@ -0,0 +1,249 @@
+#include "ImageScanner.h"
+
+#include "../Logger.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace
+{
+    using RowScanner = void(*)(const unsigned char* pRow, int Width, int& First, int& Last);
+
+    void ScanRowScalar(const unsigned char* pRow, int Width, int& First, int& Last)
+    {
+        First = Last = -1;
+        for (int i = 0; i < Width; ++i)
+        {
+            if (pRow[i])
+            {
+                First = i;
+                break;
+            }
+        }
+        if (First == -1)
+            return;
+        for (int i = Width - 1; i >= First; --i)
+        {
+            if (pRow[i])
+            {
+                Last = i;
+                break;
+            }
+        }
+    }
+
+    void ScanRowSSE2(const unsigned char* pRow, int Width, int& First, int& Last)
+    {
+        First = Last = -1;
+        const __m128i zero = _mm_setzero_si128();
+        unsigned long nIndex;
+
+        int i = 0;
+        for (; i + 16 <= Width; i += 16)
+        {
+            auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i));
+            unsigned int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(data, zero)) & 0xFFFF;
+            if (mask)
+            {
+                _BitScanForward(&nIndex, mask);
+                First = i + nIndex;
+                break;
+            }
+        }
+        if (First == -1)
+        {
+            for (; i < Width; ++i)
+            {
+                if (pRow[i])
+                {
+                    First = i;
+                    break;
+                }
+            }
+            if (First == -1)
+                return;
+        }
+
+        // pRow[First] is non-zero, so the backward scan always stops at or before it
+        int j = Width;
+        for (; j - 16 >= First; j -= 16)
+        {
+            auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + j - 16));
+            unsigned int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(data, zero)) & 0xFFFF;
+            if (mask)
+            {
+                _BitScanReverse(&nIndex, mask);
+                Last = j - 16 + nIndex;
+                return;
+            }
+        }
+        for (--j; j >= First; --j)
+        {
+            if (pRow[j])
+            {
+                Last = j;
+                return;
+            }
+        }
+    }
+
+    void ScanRowAVX2(const unsigned char* pRow, int Width, int& First, int& Last)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        unsigned long nIndex;
+
+        int i = 0;
+        int nFirst = -1, nLast = -1;
+        for (; i + 32 <= Width; i += 32)
+        {
+            auto data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow + i));
+            unsigned int mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, zero)));
+            if (mask)
+            {
+                _BitScanForward(&nIndex, mask);
+                nFirst = i + nIndex;
+                break;
+            }
+        }
+        if (nFirst != -1)
+        {
+            int j = Width;
+            for (; j - 32 >= nFirst; j -= 32)
+            {
+                auto data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow + j - 32));
+                unsigned int mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, zero)));
+                if (mask)
+                {
+                    _BitScanReverse(&nIndex, mask);
+                    nLast = j - 32 + nIndex;
+                    break;
+                }
+            }
+            if (nLast == -1)
+            {
+                for (--j; j >= nFirst; --j)
+                {
+                    if (pRow[j])
+                    {
+                        nLast = j;
+                        break;
+                    }
+                }
+            }
+        }
+        _mm256_zeroupper();
+
+        if (nFirst == -1) // less than 32 pixels left to check
+        {
+            ScanRowSSE2(pRow + i, Width - i, First, Last);
+            if (First != -1)
+            {
+                First += i;
+                Last += i;
+            }
+            return;
+        }
+
+        First = nFirst;
+        Last = nLast;
+    }
+
+    struct RowScannerSelector
+    {
+        RowScanner Scanner;
+        const char* Name;
+
+        RowScannerSelector()
+        {
+            int info[4];
+            __cpuid(info, 0);
+            int nMaxLeaf = info[0];
+
+            __cpuid(info, 1);
+            bool bSSE2 = info[3] & (1 << 26);
+            bool bOSXSAVE = info[2] & (1 << 27);
+            bool bAVX = info[2] & (1 << 28);
+
+            bool bAVX2 = false;
+            if (nMaxLeaf >= 7 && bOSXSAVE && bAVX && (_xgetbv(0) & 6) == 6)
+            {
+                __cpuidex(info, 7, 0);
+                bAVX2 = info[1] & (1 << 5);
+            }
+
+            if (bAVX2)
+            {
+                Scanner = ScanRowAVX2;
+                Name = "AVX2";
+            }
+            else if (bSSE2)
+            {
+                Scanner = ScanRowSSE2;
+                Name = "SSE2";
+            }
+            else
+            {
+                Scanner = ScanRowScalar;
+                Name = "Scalar";
+            }
+
+            Logger::Debug("ImageScanner : Using %s row scanner.\n", Name);
+        }
+    };
+
+    const RowScannerSelector& GetSelector()
+    {
+        static const RowScannerSelector selector;
+        return selector;
+    }
+}
+
+bool ImageScanner::Scan(const unsigned char* pBuffer, int Width, int Height,
+    Bounds& bounds, int* pFirst, int* pLast)
+{
+    auto const pfnScanRow = GetSelector().Scanner;
+
+    bool bFound = false;
+    Bounds result{ Width - 1, Height - 1, 0, 0 };
+    for (int j = 0; j < Height; ++j)
+    {
+        int nFirst, nLast;
+        pfnScanRow(pBuffer + j * Width, Width, nFirst, nLast);
+
+#ifdef _DEBUG
+        int nCheckFirst, nCheckLast;
+        ScanRowScalar(pBuffer + j * Width, Width, nCheckFirst, nCheckLast);
+        if (nCheckFirst != nFirst || nCheckLast != nLast)
+            Logger::Debug("ImageScanner : %s row scan mismatch at row %d, got %d-%d, expected %d-%d.\n",
+                GetSelector().Name, j, nFirst, nLast, nCheckFirst, nCheckLast);
+#endif
+
+        if (pFirst)
+            pFirst[j] = nFirst;
+        if (pLast)
+            pLast[j] = nLast;
+
+        if (nFirst == -1)
+            continue;
+
+        if (!bFound)
+        {
+            result.FirstY = j;
+            bFound = true;
+        }
+        result.LastY = j;
+        if (nFirst < result.FirstX)
+            result.FirstX = nFirst;
+        if (nLast > result.LastX)
+            result.LastX = nLast;
+    }
+
+    if (bFound)
+        bounds = result;
+    return bFound;
+}
+
+const char* ImageScanner::GetImplementationName()
+{
+    return GetSelector().Name;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// Finds the non-transparent (non-zero) pixels of an indexed color buffer.
+// Rows are scanned with AVX2 or SSE2 when the cpu supports them, scalar otherwise.
+class ImageScanner
+{
+public:
+    struct Bounds
+    {
+        int FirstX;
+        int FirstY;
+        int LastX;
+        int LastY;
+    };
+
+    // Fills pFirst/pLast (optional, Height entries each) with the first and last
+    // non-zero pixel of every row, -1 for empty rows.
+    // Returns false if the whole buffer is empty, bounds are left untouched then.
+    static bool Scan(const unsigned char* pBuffer, int Width, int Height,
+        Bounds& bounds, int* pFirst = nullptr, int* pLast = nullptr);
+
+    static const char* GetImplementationName();
+};
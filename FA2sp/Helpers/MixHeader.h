@@ -0,0 +1,134 @@
+#pragma once
+
+#include "CRC32.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Reader for the index of Westwood MIX files (TD/RA/TS/RA2 layouts)
+// Only depends on the standard library so it can be checked outside FA2
+//
+// TS/RA2 layout: uint32 flags, uint16 count, uint32 body size, count * { uint32 id, int32 offset, int32 size }, body
+// TD layout:     uint16 count, uint32 body size, count * entry, body
+// Encrypted headers (flags & 0x20000) are left to FA2, they need its RSA key
+
+class MixHeader
+{
+public:
+    struct Entry
+    {
+        unsigned int ID;
+        int Offset; // relative to the body
+        int Size;
+    };
+
+    enum : unsigned int
+    {
+        FlagChecksum = 0x10000,
+        FlagEncrypted = 0x20000
+    };
+
+    enum class Result
+    {
+        OK,
+        Encrypted,
+        Invalid
+    };
+
+    // Bytes needed to know how long the whole header is
+    static constexpr size_t PrefixSize = 10;
+
+    // Returns the size of the header in bytes, 0 for encrypted or invalid headers
+    static size_t GetHeaderSize(const unsigned char* pPrefix, size_t nLength)
+    {
+        if (nLength < PrefixSize)
+            return 0;
+
+        unsigned int nFlags = Read<unsigned int>(pPrefix);
+        if (IsTD(pPrefix))
+            return 6 + Read<unsigned short>(pPrefix) * sizeof(Entry);
+        if (nFlags & FlagEncrypted)
+            return 0;
+        return 4 + 6 + Read<unsigned short>(pPrefix + 4) * sizeof(Entry);
+    }
+
+    // nBodyOffset receives where the body starts in the file
+    static Result Parse(const unsigned char* pData, size_t nLength, std::vector<Entry>& entries, size_t& nBodyOffset)
+    {
+        entries.clear();
+        if (nLength < PrefixSize)
+            return Result::Invalid;
+
+        const unsigned char* p = pData;
+        if (!IsTD(pData))
+        {
+            if (Read<unsigned int>(p) & FlagEncrypted)
+                return Result::Encrypted;
+            p += 4;
+        }
+
+        unsigned short nCount = Read<unsigned short>(p);
+        unsigned int nBodySize = Read<unsigned int>(p + 2);
+        p += 6;
+
+        nBodyOffset = (p - pData) + nCount * sizeof(Entry);
+        if (nBodyOffset > nLength)
+            return Result::Invalid;
+
+        entries.resize(nCount);
+        for (auto& entry : entries)
+        {
+            entry.ID = Read<unsigned int>(p);
+            entry.Offset = Read<int>(p + 4);
+            entry.Size = Read<int>(p + 8);
+            p += 12;
+            if (entry.Offset < 0 || entry.Size < 0 || static_cast<unsigned int>(entry.Offset) > nBodySize
+                || static_cast<unsigned int>(entry.Size) > nBodySize - static_cast<unsigned int>(entry.Offset))
+            {
+                entries.clear();
+                return Result::Invalid;
+            }
+        }
+
+        return Result::OK;
+    }
+
+    // TS/RA2 file id, the CRC32 of the upper cased name padded to a multiple of 4
+    static unsigned int GetID(const char* pName)
+    {
+        char buffer[0x110];
+        size_t nLength = strlen(pName);
+        if (nLength > 0x100)
+            nLength = 0x100;
+
+        for (size_t i = 0; i < nLength; ++i)
+            buffer[i] = (pName[i] >= 'a' && pName[i] <= 'z') ? pName[i] - 'a' + 'A' : pName[i];
+
+        size_t nAligned = nLength & ~3u;
+        if (nLength & 3)
+        {
+            buffer[nLength] = static_cast<char>(nLength - nAligned);
+            for (size_t i = nLength + 1; i < nAligned + 4; ++i)
+                buffer[i] = buffer[nAligned];
+            nLength = nAligned + 4;
+        }
+
+        return CRC32::Compute(buffer, nLength);
+    }
+
+private:
+    // TD headers begin with a non zero file count where newer ones have zero flags in the low word
+    static bool IsTD(const unsigned char* p)
+    {
+        return Read<unsigned short>(p) != 0;
+    }
+
+    template<typename T>
+    static T Read(const unsigned char* p)
+    {
+        T ret;
+        memcpy(&ret, p, sizeof(T));
+        return ret;
+    }
+};
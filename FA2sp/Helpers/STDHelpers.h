@@ -109,4 +109,41 @@ public:
         else
             return pStr.Find(pQuery) != -1;
     }
+
+    // FNV-1a, with nHash starting from FNVOffsetBasis32 or FNVOffsetBasis64.
+    // Each string is followed by a 0xFF separator, so "a" "bc" and "ab" "c" differ.
+    static constexpr unsigned int FNVOffsetBasis32 = 2166136261u;
+    static constexpr unsigned long long FNVOffsetBasis64 = 14695981039346656037ull;
+
+    template<typename T>
+    static void HashString(T& nHash, const char* pString, size_t nLength, bool bIgnoreCase = false)
+    {
+        constexpr T nPrime = sizeof(T) == 8 ? static_cast<T>(1099511628211ull) : static_cast<T>(16777619u);
+        for (size_t i = 0; i < nLength; ++i)
+        {
+            char c = pString[i];
+            if (bIgnoreCase && c >= 'A' && c <= 'Z')
+                c = c - 'A' + 'a';
+            nHash = (nHash ^ static_cast<unsigned char>(c)) * nPrime;
+        }
+        nHash = (nHash ^ 0xFF) * nPrime;
+    }
+
+    template<typename T>
+    static void HashString(T& nHash, const char* pString)
+    {
+        HashString(nHash, pString, strlen(pString));
+    }
+
+    // Keys and values of the section, nothing if it doesn't exist
+    template<typename T>
+    static void HashSection(T& nHash, CINI* pINI, const char* pSection)
+    {
+        if (auto pSectionData = pINI->GetSection(pSection))
+            for (auto& pair : pSectionData->GetEntities())
+            {
+                HashString(nHash, pair.first, pair.first.GetLength());
+                HashString(nHash, pair.second, pair.second.GetLength());
+            }
+    }
 };
\ No newline at end of file
@@ -4,6 +4,10 @@
 #include <Helpers/Macro.h>
 #include <CINI.h>
 
+#include "../Logger.h"
+
+#include <chrono>
+
 CString FinalAlertConfig::lpPath;
 char FinalAlertConfig::pLastRead[0x400];
 
@@ -21,6 +25,7 @@ DEFINE_HOOK(41F7F5, Translations_Initialzation, 9)
     strcat_s(Translations::pLanguage[1], "-TranslationsRA2");
     strcat_s(Translations::pLanguage[2], "-Strings");
     strcat_s(Translations::pLanguage[3], "-Translations");
+    Translations::ClearTable();
     return 0;
 }
 
@@ -37,22 +42,82 @@ void FinalAlertConfig::WriteString(const char* pSection, const char* pKey, const
 };
 
 char Translations::pLanguage[4][0x400];
+std::unordered_map<std::string_view, ppmfc::CString> Translations::Table;
+std::string Translations::TableKeys;
+bool Translations::TableBuilt = false;
+size_t Translations::Lookups = 0;
+size_t Translations::Hits = 0;
+
 bool Translations::GetTranslationItem(const char* pLabelName, ppmfc::CString& ret)
 {
+    if (!TableBuilt)
+        BuildTable();
+
+    ++Lookups;
+    auto itr = Table.find(pLabelName);
+    if (itr != Table.end())
+    {
+        ++Hits;
+        ret = itr->second;
+        return true;
+    }
+
+    return false;
+}
+
+void Translations::BuildTable()
+{
+    auto begin = std::chrono::steady_clock::now();
     auto& falanguage = CINI::FALanguage();
 
-    for(const auto& language : Translations::pLanguage)
+    ClearTable();
+
+    // Keys are views into TableKeys, so it must not grow once filled
+    size_t nLength = 0;
+    size_t nCount = 0;
+    for (const auto& language : Translations::pLanguage)
+        if (auto section = falanguage.GetSection(language))
+            for (const auto& pair : section->GetEntities())
+            {
+                nLength += pair.first.GetLength();
+                ++nCount;
+            }
+    TableKeys.reserve(nLength);
+    Table.reserve(nCount);
+
+    // Sections are in precedence order, keys already in the table win
+    for (const auto& language : Translations::pLanguage)
         if (auto section = falanguage.GetSection(language))
-        {
-            auto itr = section->GetEntities().find(pLabelName);
-            if (itr != section->GetEntities().end())
+            for (const auto& pair : section->GetEntities())
             {
-                ret = itr->second;
-                return true;
+                std::string_view key{ pair.first, static_cast<size_t>(pair.first.GetLength()) };
+                if (Table.find(key) != Table.end())
+                    continue;
+                size_t nOffset = TableKeys.length();
+                TableKeys.append(key);
+                Table.emplace(std::string_view{ TableKeys.data() + nOffset, key.length() }, pair.second);
             }
-        }
 
-        return false;
+    // An empty table is built again next time, FALanguage may not be loaded yet
+    if (Table.empty())
+        return;
+
+    TableBuilt = true;
+    auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    Logger::Debug("Translations : %u items merged in %d us.\n", Table.size(), static_cast<int>(time));
+}
+
+void Translations::ClearTable()
+{
+    Table.clear();
+    TableKeys.clear();
+    TableKeys.shrink_to_fit();
+    TableBuilt = false;
+}
+
+void Translations::LogStats()
+{
+    Logger::Debug("Translations : %u lookups, %u found.\n", Lookups, Hits);
 }
 
 void Translations::TranslateItem(CWnd* pWnd, int nSubID, const char* lpKey)
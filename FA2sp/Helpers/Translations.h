@@ -2,6 +2,10 @@
 
 #include <FA2PP.h>
 
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
 // FinalAlert.ini
 class FinalAlertConfig
 {
@@ -18,6 +22,18 @@ public:
     static bool GetTranslationItem(const char* pLabelName, ppmfc::CString& ret);
     static void TranslateItem(CWnd* pWnd, int nSubID, const char* lpKey);
     static void TranslateItem(CWnd* pWnd, const char* lpKey);
+    // The four language sections merged into one table, built on the first lookup
+    static void BuildTable();
+    static void ClearTable();
+    // Logs the lookups since the last call
+    static void LogStats();
     static char pLanguage[4][0x400];
+
+private:
+    static std::unordered_map<std::string_view, ppmfc::CString> Table;
+    static std::string TableKeys; // storage of the keys in Table
+    static bool TableBuilt;
+    static size_t Lookups;
+    static size_t Hits;
 };
 
@@ -2,6 +2,11 @@
 #include <windows.h>
 #include <share.h>
 
+#include <mutex>
+
+// Auto saves log from their worker thread
+static std::mutex LoggerMutex;
+
 char Logger::pTime[24];
 char Logger::pBuffer[0x800];
 FILE* Logger::pFile;
@@ -25,6 +30,7 @@ void Logger::Close() {
 
 void Logger::Write(kLoggerType type, const char* format, va_list args) {
 	if (bInitialized) {
+		std::lock_guard<std::mutex> lock(LoggerMutex);
 		vsprintf_s(pBuffer, format, args);
 		char type_str[6];
 		switch (type)
@@ -90,6 +96,7 @@ void Logger::Raw(const char* format, ...) {
 
 void Logger::Put(const char* pBuffer) {
 	if (bInitialized) {
+		std::lock_guard<std::mutex> lock(LoggerMutex);
 		fputs(pBuffer, pFile);
 		fflush(pFile);
 	}
@@ -0,0 +1,19 @@
+#include "DocumentVersion.h"
+
+#include <Helpers/Macro.h>
+
+unsigned int DocumentVersion::Version = 1;
+
+void DocumentVersion::Bump()
+{
+    ++Version;
+}
+
+// The INI editor, then the houses being deleted and added
+DEFINE_HOOK_AGAIN(40A5CB, DocumentEdited_BumpVersion, 6)
+DEFINE_HOOK_AGAIN(44EB1C, DocumentEdited_BumpVersion, 7)
+DEFINE_HOOK(44E320, DocumentEdited_BumpVersion, 7)
+{
+    DocumentVersion::Bump();
+    return 0;
+}
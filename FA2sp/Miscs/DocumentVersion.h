@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+// Counts the edits FA2 makes to the map INI outside of placing objects: a map being
+// created or loaded, the INI editor and the houses being added or deleted.
+// Caches built from map sections keep the version they were built at and only
+// look at their sections again once it moved.
+class DocumentVersion
+{
+public:
+    static unsigned int Get() { return Version; }
+    static void Bump();
+
+private:
+    static unsigned int Version;
+};
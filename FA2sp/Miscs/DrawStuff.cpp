@@ -2,6 +2,9 @@
 
 #include <CLoading.h>
 
+#include "MixFileView.h"
+#include "ObjectImageCache.h"
+
 #include "../vxl_drawing_lib.h"
 
 void DrawStuff::init()
@@ -17,38 +20,33 @@ void DrawStuff::deinit()
 bool DrawStuff::load_vpl(ppmfc::CString name)
 {
     bool result = false;
-    DWORD dwSize;
-    if (auto pBuffer = (unsigned char*)CLoading::Instance->ReadWholeFile(name, &dwSize))
-    {
-        result = vxl_drawing_lib::load_vpl(pBuffer);
-        GameDeleteArray(pBuffer, dwSize);
-    }
+    if (MixFileView view{ name })
+        result = vxl_drawing_lib::load_vpl(view.GetData());
     return result;
 }
 
 bool DrawStuff::load_vxl(ppmfc::CString name)
 {
+    // Missing files are recorded as well, adding them later invalidates the cache
+    ObjectImageCache::RecordSource(name);
+
     bool result = false;
-    DWORD dwSize;
-    if (auto pBuffer = (unsigned char*)CLoading::Instance->ReadWholeFile(name, &dwSize))
+    if (MixFileView view{ name })
     {
         if (vxl_drawing_lib::is_loaded())
             vxl_drawing_lib::clear();
-        result = vxl_drawing_lib::load_vxl(pBuffer);
-        GameDeleteArray(pBuffer, dwSize);
+        result = vxl_drawing_lib::load_vxl(view.GetData());
     }
     return result;
 }
 
 bool DrawStuff::load_hva(ppmfc::CString name)
 {
+    ObjectImageCache::RecordSource(name);
+
     bool result = false;
-    DWORD dwSize;
-    if (auto pBuffer = (unsigned char*)CLoading::Instance->ReadWholeFile(name, &dwSize))
-    {
-        result = vxl_drawing_lib::load_hva(pBuffer);
-        GameDeleteArray(pBuffer, dwSize);
-    }
+    if (MixFileView view{ name })
+        result = vxl_drawing_lib::load_hva(view.GetData());
     return result;
 }
 
@@ -12,6 +12,7 @@
 #include <MFC/ppmfc_cstring.h>
 
 #include "../FA2sp.h"
+#include "RedrawScheduler.h"
 
 // FA2 will no longer automatically change the extension of map
 DEFINE_HOOK(42700A, CFinalSunDlg_SaveMap_Extension, 9)
@@ -130,10 +131,7 @@ DEFINE_HOOK(422EA4, CFinalSunApp_ProcessMessageFilter_UpdateTileSetBrowserView_U
 DEFINE_HOOK_AGAIN(422BF6, CFinalSunApp_ProcessMessageFilter_UpdateTileSetBrowserView_LeftAndRight, 7) // VirtualKey_Right
 DEFINE_HOOK(422B95, CFinalSunApp_ProcessMessageFilter_UpdateTileSetBrowserView_LeftAndRight, 7) // VirtualKey_Left
 {
-	CFinalSunDlg::Instance->MyViewFrame.pTileSetBrowserFrame->View.RedrawWindow(
-		nullptr, nullptr, 
-		RDW_INVALIDATE | RDW_ERASE | RDW_UPDATENOW
-	);
+	RedrawScheduler::Request(CFinalSunDlg::Instance->MyViewFrame.pTileSetBrowserFrame->View.GetSafeHwnd(), true);
 
 	return 0;
 }
@@ -175,9 +175,13 @@ DEFINE_HOOK(441910, Miscs_LoadParams_TutorialTexts, 7)
     if (ExtConfigs::TutorialTexts_Fix)
     {   
         pComboBox->DeleteAllStrings();
-        for (auto x : FA2sp::TutorialTextsMap)
-            pComboBox->AddString(x.first + " : " + x.second);
-        Logger::Debug("%d csf entities added.\n", FA2sp::TutorialTextsMap.size());
+        std::string text;
+        for (auto pEntry : FA2sp::TutorialTexts.GetSorted())
+        {
+            text.assign(pEntry->Label).append(" : ").append(pEntry->Text);
+            pComboBox->AddString(text.c_str());
+        }
+        Logger::Debug("%d csf entities added.\n", FA2sp::TutorialTexts.Size());
         return 0x441A34;
     }
     return 0;
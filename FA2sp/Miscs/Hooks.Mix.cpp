@@ -21,6 +21,9 @@ DEFINE_HOOK(5280FC, MixFile_Open_CheckRAEncrypted, 7)
 #include <CLoading.h>
 #include <CFA2Logger.h>
 
+#include "MixFileView.h"
+#include "MixIndex.h"
+
 #include <set>
 
 std::vector<int> ExtraMixes;
@@ -28,6 +31,8 @@ std::vector<int> ExtraMixes;
 DEFINE_HOOK(48A1AD, CLoading_InitMixFiles_ExtraMix, 7)
 {
 	ExtraMixes.clear();
+	MixFileView::Clear();
+	MixIndex::Clear();
 
 	if (auto pSection = CINI::FAData->GetSection("ExtraMixes"))
 	{
@@ -48,6 +53,7 @@ DEFINE_HOOK(48A1AD, CLoading_InitMixFiles_ExtraMix, 7)
 			if (auto id = CMixFile::Open(path, 0))
 			{
 				ExtraMixes.push_back(id);
+				MixIndex::AddMix(id, path);
 				CFA2Logger::WriteLine("Successfully loaded extra mix file from %s", path);
 			}
 		}
@@ -60,13 +66,10 @@ DEFINE_HOOK(48A650, CLoading_SearchFile_ExtraMix, 6)
 {
 	GET_STACK(const char*, pName, 0x4);
 
-	for (auto& id : ExtraMixes)
+	if (auto id = MixIndex::Find(pName))
 	{
-		if (CMixFile::HasFile(pName, id))
-		{
-			R->EAX(id);
-			return 0x48ABD8;
-		}
+		R->EAX(id);
+		return 0x48ABD8;
 	}
 
 	return 0;
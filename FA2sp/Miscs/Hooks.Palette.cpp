@@ -55,14 +55,10 @@ DEFINE_HOOK(48C3F6, CIsoView_InitTMPs_SkipReset, 5)
 
 DEFINE_HOOK(46DEF7, CIsoView_Draw_Palette_Iso_Set, 5)
 {
+	PalettesManager::BeginFrame();
 	PalettesManager::CacheAndTintCurrentIso();
 
 	return 0;
 }
 
-DEFINE_HOOK(474AE3, CIsoView_Draw_Palette_Iso_Revert, 6)
-{
-	PalettesManager::RestoreCurrentIso();
-
-	return 0;
-}
\ No newline at end of file
+// Reverted by CIsoView_Draw_DrawCelltagAndWaypointAndTube_EarlyUnlock, which owns 474AE3
\ No newline at end of file
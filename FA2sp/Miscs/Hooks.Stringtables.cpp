@@ -5,31 +5,45 @@
 
 #include "../FA2sp.h"
 
-#include <map>
-#include <fstream>
+#include "MixFileView.h"
 
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Labels are collected in FA2sp::TutorialTexts, which is kept after loading for TutorialTexts.Fix
 class StringtableLoader
 {
 public:
     static void LoadCSFFiles();
     static void LoadCSFFile(const char* pName);
-    static bool ParseCSFFile(char* buffer, DWORD size);
-    static void WriteCSFFile();
-    static bool LoadToBuffer();
+    // Lists the stringtableNN.csf files that exist, loose or in a mix, in loading order
+    static std::vector<ppmfc::CString> FindStringtables();
+    // Builds the merged csf image in a FA2 allocated buffer
+    static bool BuildBuffer();
+    // Converts all values to the local code page with one call
+    static bool ConvertTexts();
 
-    static std::map<CString, CString> CSFFiles_Stringtable;
     static char* pEDIBuffer;
+    static size_t nEDIBufferSize;
     static bool bLoadRes;
 };
 
 bool StringtableLoader::bLoadRes = false;
 char* StringtableLoader::pEDIBuffer = nullptr;
-std::map<CString, CString> StringtableLoader::CSFFiles_Stringtable;
+size_t StringtableLoader::nEDIBufferSize = 0;
 
 DEFINE_HOOK(492D10, CSFFiles_Stringtables_Support_1, 5)
 {
+    auto begin = std::chrono::steady_clock::now();
     StringtableLoader::LoadCSFFiles();
-    StringtableLoader::bLoadRes = StringtableLoader::LoadToBuffer();
+    StringtableLoader::bLoadRes = StringtableLoader::BuildBuffer();
+    if (ExtConfigs::TutorialTexts_Fix)
+        StringtableLoader::ConvertTexts();
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    Logger::Debug("StringtableLoader : %u csf labels (%u bytes, %u bytes arena) loaded in %d ms.\n",
+        FA2sp::TutorialTexts.Size(), StringtableLoader::nEDIBufferSize, FA2sp::TutorialTexts.GetArenaSize(), static_cast<int>(time));
+
     if (StringtableLoader::bLoadRes)
     {
         R->EDI(StringtableLoader::pEDIBuffer);
@@ -44,13 +58,11 @@ DEFINE_HOOK(49433B, CSFFiles_Stringtables_Support_2, 6)
     // Cleanning up
     if (StringtableLoader::bLoadRes)
     {
-        GameDelete(StringtableLoader::pEDIBuffer);
-        char tmpCsfFile[0x400];
-        strcpy_s(tmpCsfFile, CFinalSunApp::ExePath());
-        strcat_s(tmpCsfFile, "\\RA2Tmp.csf");
-        DeleteFile(tmpCsfFile);
-        Logger::Debug("Successfully loaded %d csf labels.\n", StringtableLoader::CSFFiles_Stringtable.size());
-        StringtableLoader::CSFFiles_Stringtable.clear();
+        GameDeleteArray(StringtableLoader::pEDIBuffer, StringtableLoader::nEDIBufferSize);
+        StringtableLoader::pEDIBuffer = nullptr;
+        StringtableLoader::nEDIBufferSize = 0;
+        if (!ExtConfigs::TutorialTexts_Fix)
+            FA2sp::TutorialTexts.Clear();
         StringtableLoader::bLoadRes = false;
     }
     return 0;
@@ -63,189 +75,76 @@ void StringtableLoader::LoadCSFFiles()
         strcpy_s(nameBuffer, CINI::FAData->GetString("Filenames", "CSFYR", "RA2MD.CSF"));
     else
         strcpy_s(nameBuffer, CINI::FAData->GetString("Filenames", "CSF", "RA2.CSF"));
+    FA2sp::TutorialTexts.Clear();
     LoadCSFFile(nameBuffer);
-    char stringtable[20];
-    for (int i = 1; i <= 99; ++i)
-    {
-        sprintf_s(stringtable, "stringtable%02d.csf", i);
+    for (auto& stringtable : FindStringtables())
         LoadCSFFile(stringtable);
-    }
-    WriteCSFFile();
 }
 
 void StringtableLoader::LoadCSFFile(const char* pName)
 {   
-    DWORD dwSize;
-    if (auto pBuffer = CLoading::Instance->ReadWholeFile(pName, &dwSize))
-        if (ParseCSFFile((char*)pBuffer, dwSize))
+    if (MixFileView view{ pName })
+        if (FA2sp::TutorialTexts.Parse((const char*)view.GetData(), view.GetSize()))
             Logger::Debug("Successfully Loaded file %s.\n", pName);
 }
 
-bool StringtableLoader::ParseCSFFile(char* buffer, DWORD size)
+std::vector<ppmfc::CString> StringtableLoader::FindStringtables()
 {
-    char* pos = buffer;
-
-    auto read_int = [&pos](const void* dest)
+    bool bExists[100] = { false };
+
+    // One directory scan for the loose files instead of opening all 99 names
+    ppmfc::CString pattern = CFinalSunApp::Instance->FilePath;
+    pattern += "\\stringtable??.csf";
+    WIN32_FIND_DATA fd;
+    HANDLE hFind = FindFirstFile(pattern, &fd);
+    if (hFind != INVALID_HANDLE_VALUE)
     {
-        memcpy((void*)dest, pos, 4);
-        pos += 4;
-    };
-
-    // Parse CSF header
-    if (memcmp(pos, " FSC", 0x4) != 0) {
-        return false;
+        do
+        {
+            const char* pNumber = fd.cFileName + 11;
+            if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && isdigit((unsigned char)pNumber[0]) && isdigit((unsigned char)pNumber[1]))
+                bExists[(pNumber[0] - '0') * 10 + pNumber[1] - '0'] = true;
+        } while (FindNextFile(hFind, &fd));
+        FindClose(hFind);
     }
-    pos += 4; // FSC
-    pos += 4; // version
-    int _numLabels;
-    read_int(&_numLabels);
-    pos += 4; // numstrings
-    pos += 4; // useless
-    pos += 4; // lang
-    // Read CSF labels
-    for (int i = 0; i < _numLabels; ++i)
+
+    // The mixes only need their file tables asked, nothing is read yet
+    char stringtable[20];
+    std::vector<ppmfc::CString> ret;
+    for (int i = 1; i <= 99; ++i)
     {
-        // Read CSF label header
-        int identifier;
-        read_int(&identifier);
-        if (identifier == 0x4C424C20) // " LBL"
-        {
-            int numPairs;
-            read_int(&numPairs);
-            int strLength;
-            read_int(&strLength);
-            
-            char* labelstr = new char[strLength + 1];
-            labelstr[strLength] = '\0';
-            memcpy_s(labelstr, strLength, pos, strLength);
-
-            pos += strLength;
-            // CSF labels are not case sensitive.
-            for (int k = 0; k < strLength; ++k)
-                labelstr[k] = tolower(labelstr[k]);
-
-            read_int(&identifier);
-            read_int(&strLength);
-
-            char* tmpWideBuffer = new char[(strLength << 1) + 2];
-            for (int i = 0; i < strLength << 1; ++i)
-                tmpWideBuffer[i] = ~pos[i];
-            wchar_t* ptrWideBuffer = reinterpret_cast<wchar_t*>(tmpWideBuffer);
-            ptrWideBuffer[strLength] = '\0';
-            
-            char* value = nullptr;
-            int valueBufferSize = WideCharToMultiByte(CP_ACP, NULL, ptrWideBuffer, strLength, value, 0, NULL, NULL) + 1;
-            value = new char[valueBufferSize];
-            WideCharToMultiByte(CP_ACP, NULL, ptrWideBuffer, strLength, value, valueBufferSize, NULL, NULL);
-            delete[] tmpWideBuffer;
-            value[valueBufferSize - 1] = '\0';
-
-            pos += (strLength << 1);
-            if (identifier == 0x53545257) // "WSTR"
-            {
-                read_int(&strLength);
-                pos += strLength;
-            }
-
-            StringtableLoader::CSFFiles_Stringtable[labelstr] = CString(value);
-            if (ExtConfigs::TutorialTexts_Fix)
-                FA2sp::TutorialTextsMap[labelstr] = value;
-
-            delete[] labelstr;
-            delete[] value;
-
-            for (int j = 1; j < numPairs; ++j) // Extra labels will be ignored here
-            {
-                read_int(&identifier);
-                read_int(&strLength);
-                pos += (strLength << 1);
-                if (identifier == 0x53545257) // "WSTR"
-                {
-                    read_int(&strLength);
-                    pos += strLength;
-                }
-            }
-        }
-        else {
-            break;
-        }
+        sprintf_s(stringtable, "stringtable%02d.csf", i);
+        if (!bExists[i])
+            bExists[i] = CMixFile::HasFile(stringtable, CLoading::Instance->SearchFile(stringtable));
+        if (bExists[i])
+            ret.push_back(stringtable);
     }
-    return true;
+    return ret;
 }
 
-void StringtableLoader::WriteCSFFile()
+bool StringtableLoader::BuildBuffer()
 {
-    char tmpCsfFile[0x400];
-    strcpy_s(tmpCsfFile, CFinalSunApp::ExePath());
-    strcat_s(tmpCsfFile, "\\RA2Tmp.csf");
-    std::ofstream fout;
-    fout.open(tmpCsfFile, std::ios::out | std::ios::trunc | std::ios::binary);
-    if (!fout.is_open())
-        return;
-
-    auto write_to_stream = [&fout](const void* buffer, size_t size = 4) {
-        fout.write((char*)buffer, size);
-    };
-
-    auto write_int = [&fout](int n) {
-        fout.write((char*)&n, 4);
-    };
-
-    // CSF header
-    write_to_stream(" FSC");
-    write_int(3);
-    write_int(StringtableLoader::CSFFiles_Stringtable.size());
-    write_int(StringtableLoader::CSFFiles_Stringtable.size());
-    write_to_stream("LMAO"); // useless
-    write_int(0);
-
-    // CSF labels
-    for (auto& lbl : StringtableLoader::CSFFiles_Stringtable)
-    {
-        // label
-        write_to_stream(" LBL");
-        write_int(1);
-        write_int(lbl.first.GetLength());
-        write_to_stream(lbl.first, lbl.first.GetLength());
-
-        // value
-        write_to_stream(" RTS");
-        wchar_t* value = nullptr;
-        int valueBufferSize = MultiByteToWideChar(CP_ACP, NULL, lbl.second, lbl.second.GetLength(), value, 0);
-        value = new wchar_t[valueBufferSize + 1];
-        MultiByteToWideChar(CP_ACP, NULL, lbl.second, lbl.second.GetLength(), value, valueBufferSize);
-        value[valueBufferSize] = '\0';
-        char* buffer = reinterpret_cast<char*>(value);
-        for (int i = 0; i < valueBufferSize << 1; ++i)
-            buffer[i] = ~buffer[i];
-        write_int(valueBufferSize);
-        write_to_stream(buffer, valueBufferSize << 1);
-        delete[] value;
-    }
-    fout.close();
+    if (!FA2sp::TutorialTexts.Size())
+        return false;
+
+    size_t nSize = FA2sp::TutorialTexts.GetImageSize();
+    pEDIBuffer = GameCreateArray<char>(nSize);
+    if (!pEDIBuffer)
+        return false;
+    nEDIBufferSize = nSize;
+    FA2sp::TutorialTexts.WriteImage(pEDIBuffer);
+
+    return true;
 }
 
-bool StringtableLoader::LoadToBuffer()
+bool StringtableLoader::ConvertTexts()
 {
-    char directoryBuffer[0x400];
-    strcpy_s(directoryBuffer, CFinalSunApp::ExePath());
-    strcat_s(directoryBuffer, "\\");
-    strcat_s(directoryBuffer, "RA2Tmp.csf");
-    std::ifstream fin;
-    fin.open(directoryBuffer, std::ios::in | std::ios::binary);
-    if (fin.is_open())
-    {
-        fin.seekg(0, std::ios::end);
-        const int size = static_cast<int>(fin.tellg());
-        if (size == 0)
-            return false;
-        fin.seekg(0, std::ios::beg);
-        StringtableLoader::pEDIBuffer = GameCreateArray<char>(size);
-        bool result = false;
-        if (StringtableLoader::pEDIBuffer)
-            fin.read(StringtableLoader::pEDIBuffer, size);
-        fin.close();
-        return true;
-    }
-    return false;
-}
\ No newline at end of file
+    auto values = FA2sp::TutorialTexts.JoinValues();
+    auto pValues = reinterpret_cast<const wchar_t*>(values.c_str());
+    int nLength = static_cast<int>(values.length());
+
+    std::string texts;
+    texts.resize(WideCharToMultiByte(CP_ACP, NULL, pValues, nLength, nullptr, 0, NULL, NULL));
+    WideCharToMultiByte(CP_ACP, NULL, pValues, nLength, &texts[0], texts.length(), NULL, NULL);
+    return FA2sp::TutorialTexts.SetTexts(std::move(texts));
+}
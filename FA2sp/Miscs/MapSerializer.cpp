@@ -0,0 +1,126 @@
+#include "MapSerializer.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    bool IsBlank(std::string_view str)
+    {
+        for (auto ch : str)
+            if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' && ch != '\f' && ch != '\v')
+                return false;
+        return true;
+    }
+
+    // "[Name]\r\n" + "Key=Value\r\n" * N + "\r\n", or 0 if the section isn't written
+    size_t MeasureSection(const MapSerializer::Section& section)
+    {
+        if (IsBlank(section.Name))
+            return 0;
+
+        size_t nSize = 0;
+        for (auto& [key, value] : section.Entries)
+            if (!IsBlank(key))
+                nSize += key.size() + value.size() + 3;
+
+        return nSize ? section.Name.size() + 4 + nSize + 2 : 0;
+    }
+
+    void FormatSection(const MapSerializer::Section& section, char* pDest)
+    {
+        auto Append = [&pDest](std::string_view str)
+        {
+            memcpy(pDest, str.data(), str.size());
+            pDest += str.size();
+        };
+
+        *pDest++ = '[';
+        Append(section.Name);
+        *pDest++ = ']';
+        Append("\r\n");
+        for (auto& [key, value] : section.Entries)
+        {
+            if (IsBlank(key))
+                continue;
+            Append(key);
+            *pDest++ = '=';
+            Append(value);
+            Append("\r\n");
+        }
+        Append("\r\n");
+    }
+}
+
+std::string MapSerializer::Serialize(std::string_view Header, const std::vector<Section>& Sections)
+{
+    const size_t nCount = Sections.size();
+
+    std::vector<size_t> offsets(nCount + 1);
+    offsets[0] = Header.size();
+    for (size_t i = 0; i < nCount; ++i)
+        offsets[i + 1] = offsets[i] + MeasureSection(Sections[i]);
+
+    std::string buffer(offsets[nCount], '\0');
+    memcpy(buffer.data(), Header.data(), Header.size());
+
+    auto FormatRange = [&](size_t nBegin, size_t nEnd)
+    {
+        for (size_t i = nBegin; i < nEnd; ++i)
+            if (offsets[i + 1] != offsets[i])
+                FormatSection(Sections[i], buffer.data() + offsets[i]);
+    };
+
+    // Small maps aren't worth the threads
+    constexpr size_t MinBytesPerThread = 1 << 20;
+    size_t nThreads = std::min<size_t>({ std::max(1u, std::thread::hardware_concurrency()), 8,
+        buffer.size() / MinBytesPerThread + 1 });
+
+    if (nThreads <= 1)
+    {
+        FormatRange(0, nCount);
+        return buffer;
+    }
+
+    // Split by output bytes rather than section count, IsoMapPack5 alone can be most of a map
+    std::vector<std::thread> threads;
+    size_t nBegin = 0;
+    for (size_t t = 1; t <= nThreads && nBegin < nCount; ++t)
+    {
+        size_t nTarget = buffer.size() * t / nThreads;
+        size_t nEnd = t == nThreads ? nCount :
+            std::lower_bound(offsets.begin() + nBegin + 1, offsets.end() - 1, nTarget) - offsets.begin();
+        if (nEnd > nBegin)
+            threads.emplace_back(FormatRange, nBegin, nEnd);
+        nBegin = nEnd;
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    return buffer;
+}
+
+bool MapSerializer::WriteFile(const char* lpPath, const std::string& Buffer)
+{
+    std::string tempPath = lpPath;
+    tempPath += ".tmp";
+
+    HANDLE hFile = CreateFile(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD dwWritten = 0;
+    bool bSuccess = ::WriteFile(hFile, Buffer.data(), static_cast<DWORD>(Buffer.size()), &dwWritten, nullptr) &&
+        dwWritten == Buffer.size();
+    CloseHandle(hFile);
+
+    if (bSuccess)
+        bSuccess = MoveFileEx(tempPath.c_str(), lpPath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    if (!bSuccess)
+        DeleteFile(tempPath.c_str());
+
+    return bSuccess;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Formats INI sections into a single buffer. Every section is measured first,
+// then they are formatted in parallel straight into their own slice of the
+// buffer, so the output keeps the original order without concatenation copies.
+// Lines end with CRLF. Keys that are blank after trimming and sections left without keys are dropped,
+// which is what SaveMap used to delete from the document before writing.
+class MapSerializer
+{
+public:
+    struct Section
+    {
+        std::string_view Name;
+        std::vector<std::pair<std::string_view, std::string_view>> Entries;
+    };
+
+    static std::string Serialize(std::string_view Header, const std::vector<Section>& Sections);
+
+    // Writes the buffer beside lpPath with one write and renames it over lpPath,
+    // so a failed save never leaves a truncated map behind
+    static bool WriteFile(const char* lpPath, const std::string& Buffer);
+};
@@ -0,0 +1,90 @@
+#include "MarkerIndex.h"
+
+#include <CINI.h>
+#include <CMapData.h>
+
+#include "DocumentVersion.h"
+
+#include <algorithm>
+#include <chrono>
+
+std::vector<MarkerIndex::Marker> MarkerIndex::Markers;
+std::vector<ppmfc::CString> MarkerIndex::WaypointLabels;
+size_t MarkerIndex::EntryCount = 0;
+unsigned int MarkerIndex::CheckedVersion = 0;
+int MarkerIndex::CellDataCount = 0;
+bool MarkerIndex::Valid = false;
+
+void MarkerIndex::Update()
+{
+    auto const pMap = &CMapData::Instance();
+    size_t nEntryCount = GetEntryCount();
+    if (Valid && nEntryCount == EntryCount && CellDataCount == pMap->CellDataCount &&
+        CheckedVersion == DocumentVersion::Get())
+        return;
+
+    auto begin = std::chrono::steady_clock::now();
+
+    EntryCount = nEntryCount;
+    CheckedVersion = DocumentVersion::Get();
+    CellDataCount = pMap->CellDataCount;
+    Markers.clear();
+    WaypointLabels.clear();
+
+    if (auto pSection = CINI::CurrentDocument->GetSection("Waypoints"))
+    {
+        WaypointLabels.reserve(pSection->GetEntities().size());
+        for (auto& pair : pSection->GetEntities())
+            WaypointLabels.push_back(pair.first);
+    }
+
+    // Rows are walked in order, so the markers come out sorted
+    int nHW = pMap->MapWidthPlusHeight;
+    for (int Y = 0; Y < nHW; ++Y)
+    {
+        for (int X = 0; X < nHW; ++X)
+        {
+            int nIndex = pMap->GetCoordIndex(X, Y);
+            if (nIndex < 0 || nIndex >= pMap->CellDataCount)
+                continue;
+
+            auto& cell = pMap->CellDatas[nIndex];
+            if (cell.Waypoint != -1 || cell.CellTag != -1 || cell.Tube != -1)
+                Markers.push_back(Marker{ X, Y, nIndex });
+        }
+    }
+
+    Valid = true;
+
+    Logger::Debug("MarkerIndex : %u markers indexed in %d ms.\n", Markers.size(),
+        static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count()));
+}
+
+void MarkerIndex::Clear()
+{
+    Markers.clear();
+    WaypointLabels.clear();
+    Valid = false;
+}
+
+const char* MarkerIndex::GetWaypointLabel(int nWaypoint)
+{
+    if (nWaypoint < 0 || nWaypoint >= static_cast<int>(WaypointLabels.size()))
+        return "";
+    return WaypointLabels[nWaypoint];
+}
+
+std::vector<MarkerIndex::Marker>::const_iterator MarkerIndex::LowerBound(int Y)
+{
+    return std::lower_bound(Markers.cbegin(), Markers.cend(), Y,
+        [](const Marker& marker, int Y) { return marker.Y < Y; });
+}
+
+size_t MarkerIndex::GetEntryCount()
+{
+    size_t nCount = 0;
+    for (auto lpSection : { "Waypoints", "CellTags", "Tubes" })
+        if (auto pSection = CINI::CurrentDocument->GetSection(lpSection))
+            nCount += pSection->GetEntities().size();
+    return nCount;
+}
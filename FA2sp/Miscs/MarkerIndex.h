@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <MFC/ppmfc_cstring.h>
+
+#include <vector>
+
+// Cells holding a waypoint, celltag or tube, sorted by Y then X so the view only
+// walks the rows it shows. It is rebuilt after a click or waypoint drag on the map,
+// once the document version moved, or when [Waypoints], [CellTags] or [Tubes]
+// gained or lost entries, which also catches undo.
+class MarkerIndex
+{
+public:
+    struct Marker
+    {
+        int X;
+        int Y;
+        int CellIndex;
+    };
+
+    // Rebuilds the index if it was marked dirty or the marker sections changed size
+    static void Update();
+    static void Clear();
+    static void MarkDirty() { Valid = false; }
+
+    // Calls func for every marker with iMin <= X < iMax and jMin <= Y < jMax
+    template<typename Func>
+    static void ForEachInView(int iMin, int iMax, int jMin, int jMax, Func&& func)
+    {
+        auto itr = LowerBound(jMin);
+        for (; itr != Markers.end() && itr->Y < jMax; ++itr)
+            if (itr->X >= iMin && itr->X < iMax)
+                func(*itr);
+    }
+
+    // The key of the nth entry in [Waypoints], which is what cells store
+    static const char* GetWaypointLabel(int nWaypoint);
+
+private:
+    static std::vector<Marker>::const_iterator LowerBound(int Y);
+    static size_t GetEntryCount();
+
+    static std::vector<Marker> Markers;
+    static std::vector<ppmfc::CString> WaypointLabels;
+    static size_t EntryCount;
+    static unsigned int CheckedVersion;
+    static int CellDataCount;
+    static bool Valid;
+};
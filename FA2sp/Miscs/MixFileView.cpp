@@ -0,0 +1,115 @@
+#include "MixFileView.h"
+
+#include <CFinalSunApp.h>
+#include <CLoading.h>
+
+#include "MixIndex.h"
+
+std::map<ppmfc::CString, MixFileView::Mapping> MixFileView::Mappings;
+size_t MixFileView::MappedCount = 0;
+size_t MixFileView::MappedBytes = 0;
+size_t MixFileView::CopiedCount = 0;
+size_t MixFileView::CopiedBytes = 0;
+
+MixFileView::MixFileView(const char* pName)
+    : pData{ nullptr }
+    , nSize{ 0 }
+    , pMappedView{ nullptr }
+    , pCopied{ nullptr }
+{
+    // Loose files in the game folder may take priority over mixes in FA2, leave them to it
+    ppmfc::CString LooseFile = CFinalSunApp::Instance->FilePath;
+    LooseFile += "\\";
+    LooseFile += pName;
+
+    const MixIndex::Location* pLocation = nullptr;
+    if (GetFileAttributes(LooseFile) == INVALID_FILE_ATTRIBUTES)
+        pLocation = MixIndex::FindLocation(pName);
+
+    if (pLocation && pLocation->Size > 0)
+    {
+        if (auto hMapping = GetMapping(MixIndex::GetMixPath(*pLocation)))
+        {
+            static DWORD dwGranularity = []()
+            {
+                SYSTEM_INFO si;
+                GetSystemInfo(&si);
+                return si.dwAllocationGranularity;
+            }();
+
+            // Only the entry is mapped, whole mixes would eat up the address space
+            DWORD dwStart = pLocation->Offset - pLocation->Offset % dwGranularity;
+            DWORD dwLength = pLocation->Offset - dwStart + pLocation->Size;
+            if (pMappedView = MapViewOfFile(hMapping, FILE_MAP_COPY, 0, dwStart, dwLength))
+            {
+                pData = static_cast<unsigned char*>(pMappedView) + (pLocation->Offset - dwStart);
+                nSize = pLocation->Size;
+                ++MappedCount;
+                MappedBytes += nSize;
+                return;
+            }
+        }
+    }
+
+    DWORD dwSize = 0;
+    if (pCopied = (unsigned char*)CLoading::Instance->ReadWholeFile(pName, &dwSize))
+    {
+        pData = pCopied;
+        nSize = dwSize;
+        ++CopiedCount;
+        CopiedBytes += nSize;
+    }
+}
+
+MixFileView::~MixFileView()
+{
+    if (pMappedView)
+        UnmapViewOfFile(pMappedView);
+    if (pCopied)
+        GameDeleteArray(pCopied, nSize);
+}
+
+void* MixFileView::GetMapping(const ppmfc::CString& Path)
+{
+    auto itr = Mappings.find(Path);
+    if (itr != Mappings.end())
+        return itr->second.hMapping;
+
+    Mapping mapping{ INVALID_HANDLE_VALUE, nullptr };
+    mapping.hFile = CreateFile(Path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mapping.hFile != INVALID_HANDLE_VALUE)
+    {
+        mapping.hMapping = CreateFileMapping(mapping.hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!mapping.hMapping)
+        {
+            Logger::Debug("MixFileView : Failed to map %s, files in it will be copied.\n", Path);
+            CloseHandle(mapping.hFile);
+            mapping.hFile = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    // Failures are kept as well so the file isn't opened again every time
+    Mappings[Path] = mapping;
+    return mapping.hMapping;
+}
+
+void MixFileView::Clear()
+{
+    for (auto& pair : Mappings)
+    {
+        if (pair.second.hMapping)
+            CloseHandle(pair.second.hMapping);
+        if (pair.second.hFile != INVALID_HANDLE_VALUE)
+            CloseHandle(pair.second.hFile);
+    }
+    Mappings.clear();
+}
+
+void MixFileView::LogStats()
+{
+    if (MappedCount || CopiedCount)
+        Logger::Debug("MixFileView : %u files (%u bytes) read in place, %u files (%u bytes) copied. "
+            "ReadWholeFile would have copied %u bytes.\n",
+            MappedCount, MappedBytes, CopiedCount, CopiedBytes, MappedBytes + CopiedBytes);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <MFC/ppmfc_cstring.h>
+
+#include <map>
+
+// Read only bytes of a game file, an alternative to CLoading::ReadWholeFile
+// for parsers that only read their input. Files found by MixIndex in an
+// unencrypted extra mix are viewed straight from a mapping of the mix,
+// anything else (loose files, encrypted or base mixes) still goes
+// through ReadWholeFile and is freed with the view.
+// Views are copy on write, so passing them to code expecting a writable buffer is safe.
+class MixFileView
+{
+public:
+    explicit MixFileView(const char* pName);
+    ~MixFileView();
+
+    MixFileView(const MixFileView&) = delete;
+    MixFileView& operator=(const MixFileView&) = delete;
+
+    explicit operator bool() const { return pData != nullptr; }
+    unsigned char* GetData() const { return pData; }
+    size_t GetSize() const { return nSize; }
+
+    // Closes the mappings, views must be gone by then
+    static void Clear();
+    static void LogStats();
+
+private:
+    static void* GetMapping(const ppmfc::CString& Path);
+
+    unsigned char* pData;
+    size_t nSize;
+    void* pMappedView; // for UnmapViewOfFile, pData points into it
+    unsigned char* pCopied; // for GameDeleteArray
+
+    struct Mapping
+    {
+        void* hFile;
+        void* hMapping;
+    };
+    static std::map<ppmfc::CString, Mapping> Mappings;
+
+    static size_t MappedCount;
+    static size_t MappedBytes;
+    static size_t CopiedCount;
+    static size_t CopiedBytes;
+};
@@ -0,0 +1,134 @@
+#include "MixIndex.h"
+
+#include <CMixFile.h>
+
+#include <fstream>
+
+#include "../Helpers/MixHeader.h"
+
+std::vector<MixIndex::Source> MixIndex::Sources;
+std::unordered_map<unsigned int, MixIndex::Location> MixIndex::Files;
+std::unordered_map<std::string, int> MixIndex::NameCache;
+size_t MixIndex::Lookups = 0;
+size_t MixIndex::CacheHits = 0;
+size_t MixIndex::Probes = 0;
+
+void MixIndex::Clear()
+{
+    LogStats();
+
+    Sources.clear();
+    Files.clear();
+    NameCache.clear();
+    Lookups = 0;
+    CacheHits = 0;
+    Probes = 0;
+}
+
+void MixIndex::AddMix(int nMix, ppmfc::CString Path)
+{
+    Sources.push_back(Source{ nMix, Path, false });
+    Sources.back().Indexed = ReadHeader(Sources.size() - 1);
+    if (!Sources.back().Indexed)
+        Logger::Debug("MixIndex : %s cannot be indexed, it will be probed through FA2.\n", Path);
+}
+
+bool MixIndex::ReadHeader(size_t nSource)
+{
+    auto& source = Sources[nSource];
+    std::ifstream fin(source.Path, std::ios::binary);
+    if (!fin.is_open())
+        return false;
+
+    std::vector<unsigned char> header(MixHeader::PrefixSize);
+    if (!fin.read(reinterpret_cast<char*>(header.data()), header.size()))
+        return false;
+
+    size_t nHeaderSize = MixHeader::GetHeaderSize(header.data(), header.size());
+    if (nHeaderSize < MixHeader::PrefixSize)
+        return false;
+
+    header.resize(nHeaderSize);
+    if (!fin.read(reinterpret_cast<char*>(header.data() + MixHeader::PrefixSize), nHeaderSize - MixHeader::PrefixSize))
+        return false;
+
+    std::vector<MixHeader::Entry> entries;
+    size_t nBodyOffset;
+    if (MixHeader::Parse(header.data(), header.size(), entries, nBodyOffset) != MixHeader::Result::OK)
+        return false;
+
+    // Mixes are added in priority order, the first one keeps the file
+    for (auto& entry : entries)
+        Files.emplace(entry.ID, Location{ source.Mix, nSource, static_cast<int>(nBodyOffset) + entry.Offset, entry.Size });
+
+    return true;
+}
+
+int MixIndex::Find(const char* pName)
+{
+    ++Lookups;
+
+    std::string key(pName);
+    for (auto& c : key)
+        c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+
+    auto itr = NameCache.find(key);
+    if (itr != NameCache.end())
+    {
+        ++CacheHits;
+        return itr->second;
+    }
+
+    int nMix = 0;
+    size_t nFirstSource = Sources.size();
+    auto file = Files.find(MixHeader::GetID(pName));
+    if (file != Files.end())
+    {
+        nMix = file->second.Mix;
+        nFirstSource = file->second.Source;
+    }
+
+    // Only encrypted mixes with higher priority could still hold it
+    for (size_t i = 0; i < nFirstSource; ++i)
+    {
+        if (Sources[i].Indexed)
+            continue;
+        ++Probes;
+        if (CMixFile::HasFile(pName, Sources[i].Mix))
+        {
+            nMix = Sources[i].Mix;
+            break;
+        }
+    }
+
+    NameCache.emplace(std::move(key), nMix);
+    return nMix;
+}
+
+const MixIndex::Location* MixIndex::FindLocation(const char* pName)
+{
+    auto file = Files.find(MixHeader::GetID(pName));
+    if (file == Files.end() || Find(pName) != file->second.Mix)
+        return nullptr;
+    return &file->second;
+}
+
+ppmfc::CString MixIndex::GetMixPath(const Location& location)
+{
+    return Sources[location.Source].Path;
+}
+
+ppmfc::CString MixIndex::GetMixPath(int nMix)
+{
+    for (auto& source : Sources)
+        if (source.Mix == nMix)
+            return source.Path;
+    return "";
+}
+
+void MixIndex::LogStats()
+{
+    if (Lookups)
+        Logger::Debug("MixIndex : %u files indexed from %u mixes, %u lookups, %u answered by cache, %u probes through FA2.\n",
+            Files.size(), Sources.size(), Lookups, CacheHits, Probes);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <MFC/ppmfc_cstring.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Index of the files in [ExtraMixes], built once when FA2 opens its mixes.
+// Unencrypted mix headers are read from disk into one hash table keyed by file id,
+// encrypted ones can only be asked through CMixFile::HasFile, so those are
+// probed in priority order and the answer is remembered per name, found or not.
+class MixIndex
+{
+public:
+    struct Location
+    {
+        int Mix; // CMixFile id
+        size_t Source; // index into Sources, lower is higher priority
+        int Offset; // from the beginning of the mix file
+        int Size;
+    };
+
+    static void Clear();
+    static void AddMix(int nMix, ppmfc::CString Path);
+    // Returns the CMixFile id holding the file, 0 if no extra mix has it
+    static int Find(const char* pName);
+    static const Location* FindLocation(const char* pName);
+    static ppmfc::CString GetMixPath(const Location& location);
+    // Empty for base mixes, they are not in [ExtraMixes]
+    static ppmfc::CString GetMixPath(int nMix);
+    static void LogStats();
+
+private:
+    struct Source
+    {
+        int Mix;
+        ppmfc::CString Path;
+        bool Indexed;
+    };
+
+    static bool ReadHeader(size_t nSource);
+
+    static std::vector<Source> Sources;
+    static std::unordered_map<unsigned int, Location> Files;
+    static std::unordered_map<std::string, int> NameCache;
+
+    static size_t Lookups;
+    static size_t CacheHits;
+    static size_t Probes;
+};
@@ -0,0 +1,105 @@
+#include "ObjectImageBudget.h"
+
+#include <Drawing.h>
+
+#include <algorithm>
+#include <vector>
+
+std::unordered_map<ImageDataClass*, ObjectImageBudget::Entry> ObjectImageBudget::Entries;
+size_t ObjectImageBudget::TotalBytes = 0;
+size_t ObjectImageBudget::EvictedCount = 0;
+unsigned int ObjectImageBudget::CurrentFrame = 0;
+
+size_t ObjectImageBudget::GetImageBytes(ImageDataClass* pData)
+{
+    return pData->FullWidth * pData->FullHeight + pData->FullHeight * sizeof(ImageDataClass::ValidRangeData);
+}
+
+void ObjectImageBudget::Register(ImageDataClass* pData)
+{
+    if (ExtConfigs::ImageCache_MaxMB <= 0)
+        return;
+
+    auto& entry = Entries[pData];
+    if (!entry.Evicted)
+        TotalBytes -= entry.Bytes;
+
+    entry.Bytes = GetImageBytes(pData);
+    entry.LastFrame = CurrentFrame;
+    entry.Evicted = false;
+    TotalBytes += entry.Bytes;
+}
+
+bool ObjectImageBudget::Touch(ImageDataClass* pData)
+{
+    auto itr = Entries.find(pData);
+    if (itr == Entries.end())
+        return false;
+
+    itr->second.LastFrame = CurrentFrame;
+    return itr->second.Evicted;
+}
+
+void ObjectImageBudget::Forget(ImageDataClass* pData)
+{
+    auto itr = Entries.find(pData);
+    if (itr == Entries.end())
+        return;
+
+    if (!itr->second.Evicted)
+        TotalBytes -= itr->second.Bytes;
+    Entries.erase(itr);
+}
+
+void ObjectImageBudget::NewFrame()
+{
+    ++CurrentFrame;
+
+    if (ExtConfigs::ImageCache_MaxMB <= 0)
+        return;
+
+    size_t nBudget = static_cast<size_t>(ExtConfigs::ImageCache_MaxMB) << 20;
+    if (TotalBytes > nBudget)
+        Evict(nBudget);
+}
+
+void ObjectImageBudget::Evict(size_t nBudget)
+{
+    std::vector<std::pair<unsigned int, ImageDataClass*>> candidates;
+    for (auto& [pData, entry] : Entries)
+        if (!entry.Evicted && entry.LastFrame + 1 < CurrentFrame) // drawn in the last paint
+            candidates.emplace_back(entry.LastFrame, pData);
+    std::sort(candidates.begin(), candidates.end());
+
+    size_t nEvicted = 0;
+    for (auto& [_, pData] : candidates)
+    {
+        if (TotalBytes <= nBudget)
+            break;
+
+        auto& entry = Entries[pData];
+        if (pData->pImageBuffer)
+        {
+            GameDeleteArray(pData->pImageBuffer, pData->FullWidth * pData->FullHeight);
+            pData->pImageBuffer = nullptr;
+        }
+        if (pData->pPixelValidRanges)
+        {
+            GameDeleteArray(pData->pPixelValidRanges, pData->FullHeight);
+            pData->pPixelValidRanges = nullptr;
+        }
+        entry.Evicted = true;
+        TotalBytes -= entry.Bytes;
+        ++nEvicted;
+    }
+
+    EvictedCount += nEvicted;
+    Logger::Debug("ObjectImageBudget : Evicted %u images (%u in total), %u bytes remain in use.\n",
+        nEvicted, EvictedCount, TotalBytes);
+}
+
+void ObjectImageBudget::Clear()
+{
+    Entries.clear();
+    TotalBytes = 0;
+}
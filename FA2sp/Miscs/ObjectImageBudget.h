@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <unordered_map>
+
+class ImageDataClass;
+
+// Keeps the object images loaded by CLoadingExt under [ExtConfigs] ImageCache.MaxMB.
+// Images not drawn recently are freed at the beginning of a paint, once drawn
+// again CLoadingExt::GetImageName notices and reloads the object.
+class ObjectImageBudget
+{
+public:
+    static void Register(ImageDataClass* pData);
+    static bool Touch(ImageDataClass* pData); // returns true if it was evicted
+    static void Forget(ImageDataClass* pData); // its buffers are about to be freed by FA2
+    static void NewFrame();
+    static void Clear();
+
+private:
+    struct Entry
+    {
+        size_t Bytes;
+        unsigned int LastFrame;
+        bool Evicted;
+    };
+
+    static size_t GetImageBytes(ImageDataClass* pData);
+    static void Evict(size_t nBudget);
+
+    static std::unordered_map<ImageDataClass*, Entry> Entries;
+    static size_t TotalBytes;
+    static size_t EvictedCount;
+    static unsigned int CurrentFrame;
+};
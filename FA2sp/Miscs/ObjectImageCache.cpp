@@ -0,0 +1,568 @@
+#include "ObjectImageCache.h"
+
+#include <CINI.h>
+#include <CLoading.h>
+#include <CFinalSunApp.h>
+#include <Drawing.h>
+
+#include "MixFileView.h"
+#include "MixIndex.h"
+#include "Palettes.h"
+#include "../Ext/CLoading/Body.h"
+#include "../Helpers/CRC32.h"
+
+#include <algorithm>
+#include <chrono>
+
+std::map<ppmfc::CString, ObjectImageCache::Entry> ObjectImageCache::Entries;
+std::map<ppmfc::CString, unsigned int> ObjectImageCache::SectionHashes;
+std::map<ppmfc::CString, unsigned int> ObjectImageCache::FileStamps;
+bool ObjectImageCache::Opened = false;
+bool ObjectImageCache::Dirty = false;
+unsigned int ObjectImageCache::EnvironmentHash = 0;
+void* ObjectImageCache::hFile = INVALID_HANDLE_VALUE;
+void* ObjectImageCache::hMapping = nullptr;
+const unsigned char* ObjectImageCache::pView = nullptr;
+
+bool ObjectImageCache::Recording = false;
+ppmfc::CString ObjectImageCache::RecordingKey;
+ppmfc::CString ObjectImageCache::RecordingID;
+std::vector<ppmfc::CString> ObjectImageCache::RecordingFiles;
+std::vector<unsigned char> ObjectImageCache::RecordingFrames;
+unsigned int ObjectImageCache::RecordingFrameCount = 0;
+
+unsigned int ObjectImageCache::Hits = 0;
+unsigned int ObjectImageCache::Misses = 0;
+unsigned int ObjectImageCache::Stales = 0;
+unsigned int ObjectImageCache::Written = 0;
+
+namespace
+{
+    // File layout, all integers are little endian uint32:
+    // "FA2C" Version EnvironmentHash EntryCount
+    // { KeyLength Key EntryLength Entry } * EntryCount
+    // Entry : SourceHash FileCount { Length Name } * FileCount
+    //         FrameCount { Length Name Length Palette FullW FullH ValidX ValidY ValidW ValidH Pixels } * FrameCount
+
+    struct CacheWriter
+    {
+        std::vector<unsigned char>& Buffer;
+
+        void Int(unsigned int n)
+        {
+            auto p = reinterpret_cast<const unsigned char*>(&n);
+            Buffer.insert(Buffer.end(), p, p + sizeof(n));
+        }
+        void Bytes(const void* pData, size_t nSize)
+        {
+            auto p = static_cast<const unsigned char*>(pData);
+            Buffer.insert(Buffer.end(), p, p + nSize);
+        }
+        void String(const ppmfc::CString& str)
+        {
+            Int(str.GetLength());
+            Bytes(static_cast<const char*>(str), str.GetLength());
+        }
+    };
+
+    struct CacheReader
+    {
+        const unsigned char* pData;
+        size_t Size;
+        size_t Pos = 0;
+
+        bool Int(unsigned int& n)
+        {
+            if (Size - Pos < sizeof(n))
+                return false;
+            memcpy(&n, pData + Pos, sizeof(n));
+            Pos += sizeof(n);
+            return true;
+        }
+        bool Bytes(const unsigned char*& p, size_t nSize)
+        {
+            if (Size - Pos < nSize)
+                return false;
+            p = pData + Pos;
+            Pos += nSize;
+            return true;
+        }
+        bool String(ppmfc::CString& str)
+        {
+            unsigned int nLength;
+            const unsigned char* p;
+            if (!Int(nLength) || !Bytes(p, nLength))
+                return false;
+            str = ppmfc::CString(reinterpret_cast<const char*>(p), nLength);
+            return true;
+        }
+    };
+}
+
+ppmfc::CString ObjectImageCache::GetCacheFileName()
+{
+    ppmfc::CString ret = CFinalSunApp::ExePath();
+    ret += "\\FA2sp.imagecache";
+    return ret;
+}
+
+ppmfc::CString ObjectImageCache::GetKey(ppmfc::CString ID)
+{
+    // The same type may be drawn with another palette once art.ini says so
+    ppmfc::CString ret;
+    ret.Format("%s|%c|%s", ID, CLoading::Instance->TheaterIdentifier,
+        CINI::Art->GetString(((CLoadingExt*)CLoading::Instance())->GetArtID(ID), "Palette"));
+    return ret;
+}
+
+unsigned int ObjectImageCache::ComputeEnvironmentHash()
+{
+    unsigned int crc = CRC32::Compute(&Version, sizeof(Version));
+
+    // Shared settings that affect every rendered object
+    const char* pSections[] =
+    {
+        "VehicleVoxelTurretsRA2", "VehicleVoxelBarrelsRA2",
+        "BuildingVoxelTurretsRA2", "BuildingVoxelBarrelsRA2",
+        "IgnoreIdleAnim", "IgnoreActiveAnim1", "IgnoreActiveAnim2",
+        "IgnoreActiveAnim3", "IgnoreActiveAnim4", "IgnoreSuperAnim1",
+        "IgnoreSuperAnim2", "IgnoreSuperAnim3", "IgnoreSuperAnim4"
+    };
+    for (auto pSectionName : pSections)
+    {
+        crc = CRC32::ComputeString(pSectionName, crc);
+        if (auto pSection = CINI::FAData->GetSection(pSectionName))
+        {
+            for (auto& pair : pSection->GetEntities())
+            {
+                crc = CRC32::ComputeString(pair.first, crc);
+                crc = CRC32::ComputeString(pair.second, crc);
+            }
+        }
+    }
+
+    if (MixFileView view{ "voxels.vpl" })
+        crc = CRC32::Compute(view.GetData(), view.GetSize(), crc);
+
+    return crc;
+}
+
+unsigned int ObjectImageCache::ComputeSourceHash(ppmfc::CString ID, const std::vector<ppmfc::CString>& files)
+{
+    unsigned int crc = GetSectionHash(ID);
+    for (auto& file : files)
+    {
+        unsigned int stamp = GetFileStamp(file);
+        crc = CRC32::Compute(&stamp, sizeof(stamp), crc);
+    }
+    return crc;
+}
+
+unsigned int ObjectImageCache::GetSectionHash(ppmfc::CString ID)
+{
+    auto itr = SectionHashes.find(ID);
+    if (itr != SectionHashes.end())
+        return itr->second;
+
+    unsigned int crc = 0;
+
+    std::vector<ppmfc::CString> hashed;
+    auto hashSection = [&](CINI* pINI, const ppmfc::CString& name, bool followValues)
+    {
+        auto pSection = pINI->GetSection(name);
+        crc = CRC32::ComputeString(name, crc);
+        if (!pSection)
+            return;
+        for (auto& pair : pSection->GetEntities())
+        {
+            crc = CRC32::ComputeString(pair.first, crc);
+            crc = CRC32::ComputeString(pair.second, crc);
+        }
+        if (!followValues)
+            return;
+        // Image, TurretAnim, BibShape, IdleAnim... all point to other sections
+        for (auto& pair : pSection->GetEntities())
+        {
+            if (std::find(hashed.begin(), hashed.end(), pair.second) != hashed.end())
+                continue;
+            if (CINI::Art->SectionExists(pair.second) || CINI::Rules->SectionExists(pair.second))
+            {
+                hashed.push_back(pair.second);
+                hashSection(&CINI::Rules(), pair.second, false);
+                hashSection(&CINI::CurrentDocument(), pair.second, false);
+                hashSection(&CINI::Art(), pair.second, false);
+            }
+        }
+    };
+
+    hashed.push_back(ID);
+    hashSection(&CINI::Rules(), ID, true);
+    hashSection(&CINI::CurrentDocument(), ID, true);
+    hashSection(&CINI::Art(), ID, true);
+
+    SectionHashes.emplace(ID, crc);
+    return crc;
+}
+
+unsigned int ObjectImageCache::GetFileStamp(const ppmfc::CString& file)
+{
+    auto itr = FileStamps.find(file);
+    if (itr != FileStamps.end())
+        return itr->second;
+
+    // Never reads the file itself, a hit must stay cheaper than rendering
+    unsigned int crc = CRC32::ComputeString(file, 0);
+
+    // Loose files take priority, the same as in MixFileView
+    ppmfc::CString LooseFile = CFinalSunApp::Instance->FilePath;
+    LooseFile += "\\";
+    LooseFile += file;
+    if (!HashFileAttributes(LooseFile, crc))
+    {
+        if (auto pLocation = MixIndex::FindLocation(file))
+        {
+            crc = CRC32::Compute(&pLocation->Offset, sizeof(pLocation->Offset), crc);
+            crc = CRC32::Compute(&pLocation->Size, sizeof(pLocation->Size), crc);
+        }
+        // Encrypted extra mixes have no directory we can read, the mix itself stands in.
+        // Files of the base mixes only change with the game, the name is all we hash.
+        else if (int nMix = MixIndex::Find(file))
+        {
+            if (!HashFileAttributes(MixIndex::GetMixPath(nMix), crc))
+                crc = ~crc;
+        }
+    }
+
+    FileStamps.emplace(file, crc);
+    return crc;
+}
+
+bool ObjectImageCache::HashFileAttributes(const char* pPath, unsigned int& crc)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!*pPath || !GetFileAttributesEx(pPath, GetFileExInfoStandard, &data))
+        return false;
+
+    crc = CRC32::Compute(&data.nFileSizeHigh, sizeof(data.nFileSizeHigh), crc);
+    crc = CRC32::Compute(&data.nFileSizeLow, sizeof(data.nFileSizeLow), crc);
+    crc = CRC32::Compute(&data.ftLastWriteTime, sizeof(data.ftLastWriteTime), crc);
+    return true;
+}
+
+void ObjectImageCache::Open()
+{
+    if (Opened)
+        return;
+
+    Opened = true;
+    EnvironmentHash = ComputeEnvironmentHash();
+
+    hFile = CreateFile(GetCacheFileName(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER liSize;
+    if (!GetFileSizeEx(hFile, &liSize) || liSize.QuadPart == 0)
+        return;
+
+    hMapping = CreateFileMapping(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping)
+        return;
+
+    pView = static_cast<const unsigned char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!pView)
+        return;
+
+    CacheReader reader{ pView, static_cast<size_t>(liSize.QuadPart) };
+    const unsigned char* pMagic;
+    unsigned int nVersion, nEnvironmentHash, nCount;
+    if (!reader.Bytes(pMagic, 4) || memcmp(pMagic, "FA2C", 4) != 0 ||
+        !reader.Int(nVersion) || nVersion != Version ||
+        !reader.Int(nEnvironmentHash) || !reader.Int(nCount))
+    {
+        Logger::Raw("ObjectImageCache : Cache file is invalid, ignored.\n");
+        return;
+    }
+
+    if (nEnvironmentHash != EnvironmentHash)
+    {
+        Logger::Raw("ObjectImageCache : FAData or voxels.vpl changed, cache discarded.\n");
+        Dirty = true;
+        return;
+    }
+
+    for (unsigned int i = 0; i < nCount; ++i)
+    {
+        ppmfc::CString key;
+        unsigned int nSize;
+        const unsigned char* pData;
+        if (!reader.String(key) || !reader.Int(nSize) || !reader.Bytes(pData, nSize))
+        {
+            Logger::Raw("ObjectImageCache : Cache file is truncated, only %u entries read.\n", i);
+            break;
+        }
+        Entries[key] = Entry{ {}, pData, nSize };
+    }
+
+    Logger::Raw("ObjectImageCache : %u entries mapped from cache file.\n", Entries.size());
+}
+
+bool ObjectImageCache::ParseEntry(const Entry& entry, unsigned int& sourceHash,
+    std::vector<ppmfc::CString>& files, std::vector<FrameView>* pFrames)
+{
+    CacheReader reader{ entry.pData, entry.Size };
+    unsigned int nFileCount;
+    if (!reader.Int(sourceHash) || !reader.Int(nFileCount))
+        return false;
+
+    files.resize(nFileCount);
+    for (auto& file : files)
+        if (!reader.String(file))
+            return false;
+
+    if (!pFrames)
+        return true;
+
+    unsigned int nFrameCount;
+    if (!reader.Int(nFrameCount))
+        return false;
+
+    pFrames->resize(nFrameCount);
+    for (auto& frame : *pFrames)
+    {
+        unsigned int values[6];
+        if (!reader.String(frame.Name) || !reader.String(frame.PaletteName))
+            return false;
+        for (auto& value : values)
+            if (!reader.Int(value))
+                return false;
+
+        frame.FullWidth = values[0];
+        frame.FullHeight = values[1];
+        frame.ValidX = values[2];
+        frame.ValidY = values[3];
+        frame.ValidWidth = values[4];
+        frame.ValidHeight = values[5];
+
+        if (frame.ValidX + frame.ValidWidth > frame.FullWidth ||
+            frame.ValidY + frame.ValidHeight > frame.FullHeight)
+            return false;
+        if (!reader.Bytes(frame.pPixels, static_cast<size_t>(frame.ValidWidth) * frame.ValidHeight))
+            return false;
+    }
+
+    return true;
+}
+
+bool ObjectImageCache::Query(ppmfc::CString ID, std::vector<FrameView>& frames)
+{
+    Open();
+
+    auto itr = Entries.find(GetKey(ID));
+    if (itr == Entries.end())
+    {
+        ++Misses;
+        return false;
+    }
+
+    unsigned int sourceHash;
+    std::vector<ppmfc::CString> files;
+    if (!ParseEntry(itr->second, sourceHash, files, &frames) || frames.empty() ||
+        ComputeSourceHash(ID, files) != sourceHash)
+    {
+        ++Misses;
+        ++Stales;
+        frames.clear();
+        return false;
+    }
+
+    ++Hits;
+    return true;
+}
+
+void ObjectImageCache::BeginRecord(ppmfc::CString ID)
+{
+    Open();
+
+    Recording = true;
+    RecordingID = ID;
+    RecordingKey = GetKey(ID);
+    RecordingFiles.clear();
+    RecordingFrames.clear();
+    RecordingFrameCount = 0;
+}
+
+void ObjectImageCache::RecordSource(ppmfc::CString FileName)
+{
+    if (!Recording)
+        return;
+
+    FileName.MakeLower();
+    if (std::find(RecordingFiles.begin(), RecordingFiles.end(), FileName) == RecordingFiles.end())
+        RecordingFiles.push_back(FileName);
+}
+
+void ObjectImageCache::RecordFrame(ppmfc::CString NameInDict, ImageDataClass* pData, Palette* pPal)
+{
+    if (!Recording)
+        return;
+
+    ppmfc::CString PaletteName = PalettesManager::GetPaletteName(pPal);
+    if (pPal != Palette::PALETTE_UNIT && pPal != Palette::PALETTE_ISO &&
+        pPal != Palette::PALETTE_THEATER && pPal != Palette::PALETTE_LIB && !PaletteName.IsEmpty())
+        RecordSource(PaletteName);
+
+    int nValidX = pData->ValidX;
+    int nValidY = pData->ValidY;
+    int nValidWidth = pData->ValidWidth;
+    int nValidHeight = pData->ValidHeight;
+    if (nValidWidth <= 0 || nValidHeight <= 0) // blank frame
+        nValidX = nValidY = nValidWidth = nValidHeight = 0;
+
+    CacheWriter writer{ RecordingFrames };
+    writer.String(NameInDict);
+    writer.String(PaletteName);
+    writer.Int(pData->FullWidth);
+    writer.Int(pData->FullHeight);
+    writer.Int(nValidX);
+    writer.Int(nValidY);
+    writer.Int(nValidWidth);
+    writer.Int(nValidHeight);
+    for (int j = 0; j < nValidHeight; ++j)
+        writer.Bytes(&pData->pImageBuffer[(nValidY + j) * pData->FullWidth + nValidX], nValidWidth);
+
+    ++RecordingFrameCount;
+}
+
+void ObjectImageCache::EndRecord()
+{
+    if (!Recording)
+        return;
+
+    Recording = false;
+    if (RecordingFrameCount == 0)
+        return;
+
+    Entry entry;
+    CacheWriter writer{ entry.Owned };
+    writer.Int(ComputeSourceHash(RecordingID, RecordingFiles));
+    writer.Int(RecordingFiles.size());
+    for (auto& file : RecordingFiles)
+        writer.String(file);
+    writer.Int(RecordingFrameCount);
+    writer.Bytes(RecordingFrames.data(), RecordingFrames.size());
+    entry.pData = entry.Owned.data();
+    entry.Size = entry.Owned.size();
+
+    Entries[RecordingKey] = std::move(entry);
+    RecordingFrames.clear();
+    RecordingFiles.clear();
+
+    ++Written;
+    Dirty = true;
+}
+
+bool ObjectImageCache::IsRecording()
+{
+    return Recording;
+}
+
+void ObjectImageCache::Save()
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    ppmfc::CString FileName = GetCacheFileName();
+    ppmfc::CString TempName = FileName + ".tmp";
+
+    HANDLE hOut = CreateFile(TempName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hOut == INVALID_HANDLE_VALUE)
+    {
+        Logger::Raw("ObjectImageCache : Failed to create %s.\n", TempName);
+        return;
+    }
+
+    std::vector<unsigned char> buffer;
+    CacheWriter writer{ buffer };
+    writer.Bytes("FA2C", 4);
+    writer.Int(Version);
+    writer.Int(EnvironmentHash);
+    writer.Int(Entries.size());
+
+    size_t nTotalSize = 0;
+    bool bSuccess = true;
+    DWORD dwWritten;
+    for (auto& [key, entry] : Entries)
+    {
+        writer.String(key);
+        writer.Int(entry.Size);
+        // Entries may still live in the mapped view, stream them out one by one
+        writer.Bytes(entry.pData, entry.Size);
+        if (!WriteFile(hOut, buffer.data(), buffer.size(), &dwWritten, nullptr))
+        {
+            bSuccess = false;
+            break;
+        }
+        nTotalSize += buffer.size();
+        buffer.clear();
+    }
+    if (bSuccess && !buffer.empty())
+    {
+        bSuccess = WriteFile(hOut, buffer.data(), buffer.size(), &dwWritten, nullptr);
+        nTotalSize += buffer.size();
+    }
+    CloseHandle(hOut);
+
+    // The view must be released before the old file can be replaced
+    Entries.clear();
+    if (pView)
+        UnmapViewOfFile(pView);
+    if (hMapping)
+        CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+    pView = nullptr;
+    hMapping = nullptr;
+    hFile = INVALID_HANDLE_VALUE;
+
+    if (!bSuccess || !MoveFileEx(TempName, FileName, MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFile(TempName);
+        Logger::Raw("ObjectImageCache : Failed to write %s.\n", FileName);
+        return;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    Logger::Raw("ObjectImageCache : Saved %u bytes in %d ms.\n", nTotalSize,
+        static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count()));
+}
+
+void ObjectImageCache::ClearHashes()
+{
+    SectionHashes.clear();
+    FileStamps.clear();
+}
+
+void ObjectImageCache::Close()
+{
+    if (!Opened)
+        return;
+
+    Logger::Raw("ObjectImageCache : %u hits, %u misses (%u stale), %u entries rendered.\n",
+        Hits, Misses, Stales, Written);
+
+    if (Dirty)
+        Save();
+
+    Entries.clear();
+    if (pView)
+        UnmapViewOfFile(pView);
+    if (hMapping)
+        CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+    pView = nullptr;
+    hMapping = nullptr;
+    hFile = INVALID_HANDLE_VALUE;
+    Opened = false;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <MFC/ppmfc_cstring.h>
+
+#include <map>
+#include <vector>
+
+class ImageDataClass;
+class Palette;
+
+// Persistent cache of the object images CLoadingExt renders from SHP/VXL files.
+// Entries are keyed by type, theater and palette. Each one stores a hash of the INI
+// sections it was built from and of where its files came from (mix directory entry,
+// or size and write time of loose files), so once anything changed the entry is
+// ignored and the object is rendered again. These hashes are worked out once per map.
+// The cache file is memory mapped, cached frames are copied out of the view directly.
+class ObjectImageCache
+{
+public:
+    struct FrameView
+    {
+        ppmfc::CString Name;
+        ppmfc::CString PaletteName;
+        int FullWidth;
+        int FullHeight;
+        int ValidX;
+        int ValidY;
+        int ValidWidth;
+        int ValidHeight;
+        const unsigned char* pPixels; // ValidWidth * ValidHeight
+    };
+
+    static bool Query(ppmfc::CString ID, std::vector<FrameView>& frames);
+
+    static void BeginRecord(ppmfc::CString ID);
+    static void RecordSource(ppmfc::CString FileName);
+    static void RecordFrame(ppmfc::CString NameInDict, ImageDataClass* pData, Palette* pPal);
+    static void EndRecord();
+    static bool IsRecording();
+
+    // Forgets the hashes worked out so far, the INIs and files may differ from now on
+    static void ClearHashes();
+    static void Close();
+
+private:
+    struct Entry
+    {
+        std::vector<unsigned char> Owned;
+        const unsigned char* pData;
+        size_t Size;
+    };
+
+    static void Open();
+    static void Save();
+    static ppmfc::CString GetCacheFileName();
+    static ppmfc::CString GetKey(ppmfc::CString ID);
+    static unsigned int ComputeEnvironmentHash();
+    static unsigned int ComputeSourceHash(ppmfc::CString ID, const std::vector<ppmfc::CString>& files);
+    static unsigned int GetSectionHash(ppmfc::CString ID);
+    static unsigned int GetFileStamp(const ppmfc::CString& file);
+    static bool HashFileAttributes(const char* pPath, unsigned int& crc);
+    static bool ParseEntry(const Entry& entry, unsigned int& sourceHash,
+        std::vector<ppmfc::CString>& files, std::vector<FrameView>* pFrames);
+
+    static constexpr unsigned int Version = 4;
+
+    static std::map<ppmfc::CString, Entry> Entries;
+    static std::map<ppmfc::CString, unsigned int> SectionHashes;
+    static std::map<ppmfc::CString, unsigned int> FileStamps;
+    static bool Opened;
+    static bool Dirty;
+    static unsigned int EnvironmentHash;
+    static void* hFile;
+    static void* hMapping;
+    static const unsigned char* pView;
+
+    static bool Recording;
+    static ppmfc::CString RecordingKey;
+    static ppmfc::CString RecordingID;
+    static std::vector<ppmfc::CString> RecordingFiles;
+    static std::vector<unsigned char> RecordingFrames;
+    static unsigned int RecordingFrameCount;
+
+    static unsigned int Hits;
+    static unsigned int Misses;
+    static unsigned int Stales;
+    static unsigned int Written;
+};
@@ -0,0 +1,85 @@
+#include "ObjectLoadQueue.h"
+
+#include <CFinalSunDlg.h>
+#include <CLoading.h>
+
+#include "RedrawScheduler.h"
+
+#include "../Ext/CLoading/Body.h"
+
+bool ObjectLoadQueue::IsDrawing = false;
+UINT_PTR ObjectLoadQueue::Timer = NULL;
+std::deque<ObjectLoadQueue::PendingObject> ObjectLoadQueue::Pending;
+std::set<ppmfc::CString> ObjectLoadQueue::PendingIDs;
+size_t ObjectLoadQueue::MaxDepth = 0;
+size_t ObjectLoadQueue::LoadedCount = 0;
+long long ObjectLoadQueue::TotalLatency = 0;
+long long ObjectLoadQueue::MaxLatency = 0;
+
+void ObjectLoadQueue::Push(ppmfc::CString ID)
+{
+    if (!PendingIDs.insert(ID).second)
+        return;
+
+    Pending.push_back(PendingObject{ ID, std::chrono::steady_clock::now() });
+    if (Pending.size() > MaxDepth)
+        MaxDepth = Pending.size();
+
+    if (Timer == NULL)
+    {
+        if (!(Timer = SetTimer(NULL, NULL, 15, ProcessCallback)))
+            Logger::Debug("ObjectLoadQueue : Failed to create timer!\n");
+    }
+}
+
+void ObjectLoadQueue::Clear()
+{
+    StopTimer();
+    Pending.clear();
+    PendingIDs.clear();
+}
+
+void ObjectLoadQueue::StopTimer()
+{
+    if (Timer != NULL)
+    {
+        KillTimer(NULL, Timer);
+        Timer = NULL;
+    }
+}
+
+void CALLBACK ObjectLoadQueue::ProcessCallback(HWND hwnd, UINT message, UINT iTimerID, DWORD dwTime)
+{
+    if (IsDrawing)
+        return;
+
+    // Keep each slice short enough for the view to stay responsive
+    bool bLoaded = false;
+    auto begin = std::chrono::steady_clock::now();
+    while (!Pending.empty() && std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(10))
+    {
+        auto item = Pending.front();
+        Pending.pop_front();
+
+        ((CLoadingExt*)CLoading::Instance())->CLoadingExt::LoadObjects(item.ID);
+        PendingIDs.erase(item.ID);
+
+        auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - item.Time).count();
+        TotalLatency += latency;
+        if (latency > MaxLatency)
+            MaxLatency = latency;
+        ++LoadedCount;
+        bLoaded = true;
+    }
+
+    if (Pending.empty())
+    {
+        StopTimer();
+        Logger::Debug("ObjectLoadQueue : %u objects loaded, max depth %u, latency avg %d ms max %d ms.\n",
+            LoadedCount, MaxDepth, static_cast<int>(LoadedCount ? TotalLatency / LoadedCount : 0), static_cast<int>(MaxLatency));
+    }
+
+    if (bLoaded)
+        RedrawScheduler::RequestIsoView();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <MFC/ppmfc_cstring.h>
+
+#include <chrono>
+#include <deque>
+#include <set>
+
+// Objects first met while CIsoView is drawing are queued here instead of being
+// loaded in the middle of the paint, the view draws their placeholder outline
+// until the queue loads them a few at a time on timer ticks and repaints.
+// FA2's mix and shp readers are not thread safe, so the work stays on the UI thread.
+class ObjectLoadQueue
+{
+public:
+    static bool IsDrawing;
+
+    static void Push(ppmfc::CString ID);
+    static void Clear();
+    static bool HasPending() { return !Pending.empty(); }
+    static bool IsPending(const ppmfc::CString& ID) { return PendingIDs.count(ID) > 0; }
+    static void CALLBACK ProcessCallback(HWND hwnd, UINT message, UINT iTimerID, DWORD dwTime);
+
+private:
+    struct PendingObject
+    {
+        ppmfc::CString ID;
+        std::chrono::steady_clock::time_point Time;
+    };
+
+    static void StopTimer();
+
+    static UINT_PTR Timer;
+    static std::deque<PendingObject> Pending;
+    static std::set<ppmfc::CString> PendingIDs;
+
+    static size_t MaxDepth;
+    static size_t LoadedCount;
+    static long long TotalLatency;
+    static long long MaxLatency;
+};
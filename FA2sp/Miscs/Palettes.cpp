@@ -9,12 +9,28 @@
 
 #include "../Ext/CFinalSunDlg/Body.h"
 
+#include "MixFileView.h"
+#include "../Helpers/CRC32.h"
+
 const LightingStruct LightingStruct::NoLighting = { -1,-1,-1,-1,-1,-1 };
+LightingStruct LightingStruct::Current = LightingStruct::NoLighting;
+unsigned int LightingStruct::Version = 0;
+bool LightingStruct::Dirty = true;
 
 std::map<ppmfc::CString, Palette*> PalettesManager::OriginPaletteFiles;
-std::map<Palette*, std::map<std::pair<BGRStruct, LightingStruct>, LightingPalette>> PalettesManager::CalculatedPaletteFiles;
 Palette* PalettesManager::CurrentIso;
+std::map<PalettesManager::CalculatedKey, PalettesManager::CalculatedEntry> PalettesManager::CalculatedPaletteFiles;
+std::list<PalettesManager::CalculatedKey> PalettesManager::CalculatedLRU;
+std::unordered_multimap<unsigned int, std::weak_ptr<Palette>> PalettesManager::UniquePalettes;
+unsigned int PalettesManager::CurrentFrame = 0;
 bool PalettesManager::ManualReloadTMP = false;
+std::unordered_map<PalettesManager::LookupKey, PalettesManager::CalculatedEntry*, PalettesManager::LookupKeyHasher> PalettesManager::LookupCache;
+unsigned int PalettesManager::LookupCacheVersion = 0;
+size_t PalettesManager::FrameLookups = 0;
+size_t PalettesManager::FrameMisses = 0;
+size_t PalettesManager::TotalLookups = 0;
+size_t PalettesManager::TotalMisses = 0;
+std::unordered_map<unsigned int, std::array<BGRStruct, 16>> LightingPalette::RemapRamps;
 
 void PalettesManager::Init()
 {
@@ -51,7 +67,17 @@ void PalettesManager::Release()
             pair.second != Palette::PALETTE_LIB)
             GameDelete(pair.second);
 
+    if (PalettesManager::TotalLookups)
+        Logger::Debug("PalettesManager : %u palette lookups, %u palettes calculated, %u kept taking %u bytes.\n",
+            PalettesManager::TotalLookups, PalettesManager::TotalMisses, GetCalculatedCount(), GetCalculatedBytes());
+    PalettesManager::TotalLookups = 0;
+    PalettesManager::TotalMisses = 0;
+
+    PalettesManager::LookupCache.clear();
     PalettesManager::CalculatedPaletteFiles.clear();
+    PalettesManager::CalculatedLRU.clear();
+    PalettesManager::UniquePalettes.clear();
+    LightingStruct::Invalidate();
 
     PalettesManager::RestoreCurrentIso();
 
@@ -95,8 +121,9 @@ Palette* PalettesManager::LoadPalette(ppmfc::CString palname)
     if (itr != PalettesManager::OriginPaletteFiles.end())
         return itr->second;
 
-    if (auto pBuffer = (BytePalette*)CLoading::Instance->ReadWholeFile(palname))
+    if (MixFileView view{ palname })
     {
+        auto pBuffer = (const BytePalette*)view.GetData();
         auto pPalette = GameCreate<Palette>();
         for (int i = 0; i < 256; ++i)
         {
@@ -104,7 +131,6 @@ Palette* PalettesManager::LoadPalette(ppmfc::CString palname)
             pPalette->Data[i].G = pBuffer->Data[i].green << 2;
             pPalette->Data[i].B = pBuffer->Data[i].blue << 2;
         }
-        GameDelete(pBuffer);
         PalettesManager::OriginPaletteFiles[palname] = pPalette;
         return pPalette;
     }
@@ -112,18 +138,47 @@ Palette* PalettesManager::LoadPalette(ppmfc::CString palname)
     return nullptr;
 }
 
+ppmfc::CString PalettesManager::GetPaletteName(Palette* pPal)
+{
+    // Builtin palettes are registered under several names, any of them loads the same palette
+    for (auto& pair : PalettesManager::OriginPaletteFiles)
+        if (pair.second == pPal)
+            return pair.first;
+
+    return "";
+}
+
 Palette* PalettesManager::GetPalette(Palette* pPal, BGRStruct& color, bool remap)
 {
-    LightingStruct lighting = LightingStruct::GetCurrentLighting();
+    ++PalettesManager::FrameLookups;
 
-    auto itr = PalettesManager::CalculatedPaletteFiles[pPal].find(std::make_pair(color, lighting));
-    if (itr != PalettesManager::CalculatedPaletteFiles[pPal].end())
-        return itr->second.GetPalette();
+    const LightingStruct& lighting = LightingStruct::GetCurrentLighting();
+    if (PalettesManager::LookupCacheVersion != LightingStruct::GetVersion())
+    {
+        PalettesManager::LookupCache.clear();
+        PalettesManager::LookupCacheVersion = LightingStruct::GetVersion();
+    }
 
-    auto& p = PalettesManager::CalculatedPaletteFiles[pPal].emplace(
-        std::make_pair(std::make_pair(color, lighting), LightingPalette(*pPal))
-    ).first->second;
+    LookupKey key{ pPal, static_cast<unsigned int>(color.R << 16 | color.G << 8 | color.B) };
+    auto cached = PalettesManager::LookupCache.find(key);
+    if (cached != PalettesManager::LookupCache.end())
+    {
+        TouchCalculated(*cached->second);
+        return cached->second->pColors.get();
+    }
 
+    auto calculatedKey = std::make_pair(pPal, std::make_pair(color, lighting));
+    auto itr = PalettesManager::CalculatedPaletteFiles.find(calculatedKey);
+    if (itr != PalettesManager::CalculatedPaletteFiles.end())
+    {
+        TouchCalculated(itr->second);
+        PalettesManager::LookupCache[key] = &itr->second;
+        return itr->second.pColors.get();
+    }
+
+    ++PalettesManager::FrameMisses;
+
+    LightingPalette p(*pPal);
     if (remap)
         p.RemapColors(color);
     else
@@ -134,10 +189,130 @@ Palette* PalettesManager::GetPalette(Palette* pPal, BGRStruct& color, bool remap
         p.AdjustLighting(lighting);
         p.TintColors();
     }
-    return p.GetPalette();
+
+    EvictCalculated();
+
+    PalettesManager::CalculatedLRU.push_front(calculatedKey);
+    auto& entry = PalettesManager::CalculatedPaletteFiles[calculatedKey];
+    entry.pColors = GetUniquePalette(*p.GetPalette());
+    entry.LastFrame = PalettesManager::CurrentFrame;
+    entry.LRU = PalettesManager::CalculatedLRU.begin();
+    PalettesManager::LookupCache[key] = &entry;
+    return entry.pColors.get();
+}
+
+std::shared_ptr<Palette> PalettesManager::GetUniquePalette(const Palette& colors)
+{
+    unsigned int nHash = CRC32::Compute(&colors, sizeof(Palette));
+    auto range = PalettesManager::UniquePalettes.equal_range(nHash);
+    for (auto itr = range.first; itr != range.second; ++itr)
+    {
+        if (auto pExisting = itr->second.lock())
+            if (memcmp(pExisting.get(), &colors, sizeof(Palette)) == 0)
+                return pExisting;
+    }
+
+    auto pColors = std::make_shared<Palette>(colors);
+    PalettesManager::UniquePalettes.emplace(nHash, pColors);
+    return pColors;
+}
+
+void PalettesManager::TouchCalculated(CalculatedEntry& entry)
+{
+    entry.LastFrame = PalettesManager::CurrentFrame;
+    PalettesManager::CalculatedLRU.splice(PalettesManager::CalculatedLRU.begin(), PalettesManager::CalculatedLRU, entry.LRU);
+}
+
+// Palettes handed out in this frame may still be in use, so they are never evicted
+void PalettesManager::EvictCalculated()
+{
+    bool bEvicted = false;
+    while (PalettesManager::CalculatedPaletteFiles.size() >= MaxCalculatedPalettes)
+    {
+        auto itr = PalettesManager::CalculatedPaletteFiles.find(PalettesManager::CalculatedLRU.back());
+        if (itr->second.LastFrame == PalettesManager::CurrentFrame)
+            break;
+
+        bool bLastUser = itr->second.pColors.use_count() == 1;
+        unsigned int nHash = bLastUser ? CRC32::Compute(itr->second.pColors.get(), sizeof(Palette)) : 0;
+        PalettesManager::CalculatedPaletteFiles.erase(itr);
+        PalettesManager::CalculatedLRU.pop_back();
+        bEvicted = true;
+
+        if (bLastUser)
+        {
+            auto range = PalettesManager::UniquePalettes.equal_range(nHash);
+            for (auto unique = range.first; unique != range.second;)
+            {
+                if (unique->second.expired())
+                    unique = PalettesManager::UniquePalettes.erase(unique);
+                else
+                    ++unique;
+            }
+        }
+    }
+
+    if (bEvicted)
+        PalettesManager::LookupCache.clear();
+}
+
+size_t PalettesManager::GetCalculatedCount()
+{
+    return PalettesManager::CalculatedPaletteFiles.size();
+}
+
+size_t PalettesManager::GetCalculatedBytes()
+{
+    return PalettesManager::UniquePalettes.size() * sizeof(Palette);
+}
+
+// The lighting can't change in the middle of a paint, so reading it once per frame is enough
+void PalettesManager::BeginFrame()
+{
+    ++PalettesManager::CurrentFrame;
+    LightingStruct::Invalidate();
+    PalettesManager::FrameLookups = 0;
+    PalettesManager::FrameMisses = 0;
+}
+
+void PalettesManager::EndFrame()
+{
+    PalettesManager::TotalLookups += PalettesManager::FrameLookups;
+    PalettesManager::TotalMisses += PalettesManager::FrameMisses;
+    if (PalettesManager::FrameMisses)
+        Logger::Debug("PalettesManager : %u palette lookups this frame, %u palettes calculated, lighting version %u. "
+            "%u palettes kept taking %u bytes.\n",
+            PalettesManager::FrameLookups, PalettesManager::FrameMisses, LightingStruct::GetVersion(),
+            GetCalculatedCount(), GetCalculatedBytes());
+}
+
+const LightingStruct& LightingStruct::GetCurrentLighting()
+{
+    if (LightingStruct::Dirty)
+    {
+        auto lighting = LightingStruct::ReadCurrentLighting();
+        if (lighting != LightingStruct::Current)
+        {
+            LightingStruct::Current = lighting;
+            ++LightingStruct::Version;
+        }
+        LightingStruct::Dirty = false;
+    }
+    return LightingStruct::Current;
 }
 
-LightingStruct LightingStruct::GetCurrentLighting()
+unsigned int LightingStruct::GetVersion()
+{
+    LightingStruct::GetCurrentLighting();
+    return LightingStruct::Version;
+}
+
+void LightingStruct::Invalidate()
+{
+    LightingStruct::Dirty = true;
+}
+
+LightingStruct LightingStruct::ReadCurrentLighting()
 {
     LightingStruct ret;
     switch (CFinalSunDlgExt::CurrentLighting)
@@ -178,7 +353,7 @@ LightingPalette::LightingPalette(Palette& originPal)
     this->ResetColors();
 }
 
-void LightingPalette::AdjustLighting(LightingStruct& lighting, int level, bool tint)
+void LightingPalette::AdjustLighting(const LightingStruct& lighting, int level, bool tint)
 {
     this->AmbientMult = lighting.Ambient - lighting.Ground + lighting.Level * level;
     if (tint)
@@ -197,23 +372,63 @@ void LightingPalette::ResetColors()
 void LightingPalette::RemapColors(BGRStruct color)
 {
     this->ResetColors();
+    auto& ramp = GetRemapRamp(color);
     for (int i = 16; i <= 31; ++i)
+        this->Colors[i] = ramp[i - 16];
+}
+
+const std::array<BGRStruct, 16>& LightingPalette::GetRemapRamp(BGRStruct color)
+{
+    unsigned int nKey = color.R << 16 | color.G << 8 | color.B;
+    auto itr = LightingPalette::RemapRamps.find(nKey);
+    if (itr != LightingPalette::RemapRamps.end())
+        return itr->second;
+
+    static const auto Factors = []()
     {
-        int ii = i - 16;
-        double cosval = ii * 0.08144869842640204 + 0.3490658503988659;
-        double sinval = ii * 0.04654211338651545 + 0.8726646259971648;
-        if (!ii)
-            cosval = 0.1963495408493621;
-
-        RGBClass rgb_remap{ color.R,color.G,color.B };
-        HSVClass hsv_remap = rgb_remap;
-        hsv_remap.H = hsv_remap.H;
-        hsv_remap.S = (unsigned char)(std::sin(sinval) * hsv_remap.S);
-        hsv_remap.V = (unsigned char)(std::cos(cosval) * hsv_remap.V);
+        std::array<std::pair<double, double>, 16> ret; // sin for S, cos for V
+        for (int ii = 0; ii < 16; ++ii)
+        {
+            double cosval = ii * 0.08144869842640204 + 0.3490658503988659;
+            double sinval = ii * 0.04654211338651545 + 0.8726646259971648;
+            if (!ii)
+                cosval = 0.1963495408493621;
+            ret[ii] = { std::sin(sinval), std::cos(cosval) };
+        }
+        return ret;
+    }();
+
+    auto& ramp = LightingPalette::RemapRamps[nKey];
+    RGBClass rgb_remap{ color.R,color.G,color.B };
+    HSVClass hsv_origin = rgb_remap;
+    for (int ii = 0; ii < 16; ++ii)
+    {
+        HSVClass hsv_remap = hsv_origin;
+        hsv_remap.S = (unsigned char)(Factors[ii].first * hsv_remap.S);
+        hsv_remap.V = (unsigned char)(Factors[ii].second * hsv_remap.V);
         RGBClass result = hsv_remap;
 
-        this->Colors[i] = { result.B,result.G,result.R };
+        ramp[ii] = { result.B,result.G,result.R };
     }
+    return ramp;
+}
+
+const std::array<std::array<unsigned char, 256>, 3>& LightingPalette::GetTintTables(float rmult, float gmult, float bmult)
+{
+    // Palettes are mostly calculated in a row for the same lighting
+    static float LastMults[3] = { -1.0f, -1.0f, -1.0f };
+    static std::array<std::array<unsigned char, 256>, 3> Tables;
+
+    const float mults[3] = { rmult, gmult, bmult };
+    for (int c = 0; c < 3; ++c)
+    {
+        if (LastMults[c] == mults[c])
+            continue;
+        LastMults[c] = mults[c];
+        for (int i = 0; i < 256; ++i)
+            Tables[c][i] = (unsigned char)std::min(i * mults[c], 255.0f);
+    }
+    return Tables;
 }
 
 void LightingPalette::TintColors(bool isObject)
@@ -223,28 +438,48 @@ void LightingPalette::TintColors(bool isObject)
     this->BlueMult = std::clamp(this->BlueMult, 0.0f, 2.0f);
     this->AmbientMult = std::clamp(this->AmbientMult, 0.0f, 2.0f);
 
+#ifdef _DEBUG
+    LightingPalette reference = *this;
+    reference.TintColorsReference(isObject);
+#endif
+
+    auto& tables = GetTintTables(
+        this->AmbientMult * this->RedMult,
+        this->AmbientMult * this->GreenMult,
+        this->AmbientMult * this->BlueMult
+    );
+
+    // 240 ~ 254 are kept for objects
+    for (int i = 0; i < 256; ++i)
+    {
+        if (isObject && i >= 240 && i < 255)
+            continue;
+        this->Colors[i].R = tables[0][this->Colors[i].R];
+        this->Colors[i].G = tables[1][this->Colors[i].G];
+        this->Colors[i].B = tables[2][this->Colors[i].B];
+    }
+
+#ifdef _DEBUG
+    if (memcmp(&reference.Colors, &this->Colors, sizeof(Palette)) != 0)
+        Logger::Debug("LightingPalette::TintColors : Mismatch against the float path!\n");
+#endif
+}
+
+// Per channel float path, the tables above must give the same colors
+void LightingPalette::TintColorsReference(bool isObject)
+{
     auto rmult = this->AmbientMult * this->RedMult;
     auto gmult = this->AmbientMult * this->GreenMult;
     auto bmult = this->AmbientMult * this->BlueMult;
 
-    for (int i = 0; i < 240; ++i)
+    for (int i = 0; i < 256; ++i)
     {
+        if (isObject && i >= 240 && i < 255)
+            continue;
         this->Colors[i].R = (unsigned char)std::min(this->Colors[i].R * rmult, 255.0f);
         this->Colors[i].G = (unsigned char)std::min(this->Colors[i].G * gmult, 255.0f);
         this->Colors[i].B = (unsigned char)std::min(this->Colors[i].B * bmult, 255.0f);
     }
-    if (!isObject)
-    {
-        for (int i = 240; i < 255; ++i)
-        {
-            this->Colors[i].R = (unsigned char)std::min(this->Colors[i].R * rmult, 255.0f);
-            this->Colors[i].G = (unsigned char)std::min(this->Colors[i].G * gmult, 255.0f);
-            this->Colors[i].B = (unsigned char)std::min(this->Colors[i].B * bmult, 255.0f);
-        }
-    }
-    this->Colors[255].R = (unsigned char)std::min(this->Colors[255].R * rmult, 255.0f);
-    this->Colors[255].G = (unsigned char)std::min(this->Colors[255].G * gmult, 255.0f);
-    this->Colors[255].B = (unsigned char)std::min(this->Colors[255].B * bmult, 255.0f);
 }
 
 Palette* LightingPalette::GetPalette()
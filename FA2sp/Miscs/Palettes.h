@@ -4,7 +4,11 @@
 
 #include <CPalette.h>
 
+#include <array>
+#include <list>
 #include <map>
+#include <memory>
+#include <unordered_map>
 
 // References from ccmaps-net
 // In fact the lighting should just be integers (from YR)
@@ -46,9 +50,20 @@ struct LightingStruct
             std::tie(another.Red, another.Green, another.Blue, another.Ground, another.Ambient, another.Level);
     }
 
-    static LightingStruct GetCurrentLighting();
+    // Snapshot of [Lighting] for CFinalSunDlgExt::CurrentLighting, read again only once invalidated.
+    // The version changes whenever the snapshot does.
+    static const LightingStruct& GetCurrentLighting();
+    static unsigned int GetVersion();
+    static void Invalidate();
 
     static const LightingStruct NoLighting;
+
+private:
+    static LightingStruct ReadCurrentLighting();
+
+    static LightingStruct Current;
+    static unsigned int Version;
+    static bool Dirty;
 };
 
 class LightingPalette
@@ -63,19 +78,72 @@ private:
 
 public:
     LightingPalette(Palette& originPal);
-    void AdjustLighting(LightingStruct& lighting, int level = 0, bool tint = true);
+    void AdjustLighting(const LightingStruct& lighting, int level = 0, bool tint = true);
     void ResetColors();
     void RemapColors(BGRStruct color);
     void TintColors(bool isObject = false);
     Palette* GetPalette();
+
+private:
+    // The 16 remapped colors only depend on the house color
+    static const std::array<BGRStruct, 16>& GetRemapRamp(BGRStruct color);
+    // Same results as min(c * mult, 255) in float, built once per set of multipliers
+    static const std::array<std::array<unsigned char, 256>, 3>& GetTintTables(float rmult, float gmult, float bmult);
+    void TintColorsReference(bool isObject);
+
+    static std::unordered_map<unsigned int, std::array<BGRStruct, 16>> RemapRamps;
 };
 
 class PalettesManager
 {
     static std::map<ppmfc::CString, Palette*> OriginPaletteFiles;
-    static std::map<Palette*, std::map<std::pair<BGRStruct, LightingStruct>, LightingPalette>> CalculatedPaletteFiles;
     static Palette* CurrentIso;
 
+    // Calculated palettes are kept in a LRU list of at most MaxCalculatedPalettes entries,
+    // entries with identical colors share one buffer
+    using CalculatedKey = std::pair<Palette*, std::pair<BGRStruct, LightingStruct>>;
+    struct CalculatedEntry
+    {
+        std::shared_ptr<Palette> pColors;
+        unsigned int LastFrame;
+        std::list<CalculatedKey>::iterator LRU;
+    };
+    static constexpr size_t MaxCalculatedPalettes = 512;
+    static std::map<CalculatedKey, CalculatedEntry> CalculatedPaletteFiles;
+    static std::list<CalculatedKey> CalculatedLRU;
+    static std::unordered_multimap<unsigned int, std::weak_ptr<Palette>> UniquePalettes;
+    static unsigned int CurrentFrame;
+
+    static std::shared_ptr<Palette> GetUniquePalette(const Palette& colors);
+    static void TouchCalculated(CalculatedEntry& entry);
+    static void EvictCalculated();
+
+    // (palette, house color) => result for the current lighting version
+    struct LookupKey
+    {
+        Palette* pPal;
+        unsigned int Color;
+
+        bool operator==(const LookupKey& another) const
+        {
+            return pPal == another.pPal && Color == another.Color;
+        }
+    };
+    struct LookupKeyHasher
+    {
+        size_t operator()(const LookupKey& key) const
+        {
+            return std::hash<Palette*>()(key.pPal) ^ (static_cast<size_t>(key.Color) * 0x9E3779B1u);
+        }
+    };
+    static std::unordered_map<LookupKey, CalculatedEntry*, LookupKeyHasher> LookupCache;
+    static unsigned int LookupCacheVersion;
+
+    static size_t FrameLookups;
+    static size_t FrameMisses;
+    static size_t TotalLookups;
+    static size_t TotalMisses;
+
 public:
 
     static void Init();
@@ -89,5 +157,12 @@ public:
     static Palette* GetCurrentIso();
     static void CacheAndTintCurrentIso();
     static Palette* LoadPalette(ppmfc::CString palname);
+    static ppmfc::CString GetPaletteName(Palette* pPal);
     static Palette* GetPalette(Palette* pPal, BGRStruct& color, bool remap = true);
+
+    static void BeginFrame();
+    static void EndFrame();
+
+    static size_t GetCalculatedCount();
+    static size_t GetCalculatedBytes();
 };
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "RedrawScheduler.h"
+
+#include <CFinalSunDlg.h>
+
+#include "ObjectLoadQueue.h"
+
+UINT_PTR RedrawScheduler::Timer = NULL;
+std::map<HWND, RedrawScheduler::PendingRedraw> RedrawScheduler::Pending;
+float RedrawScheduler::ScrollX = 0.0f;
+float RedrawScheduler::ScrollY = 0.0f;
+size_t RedrawScheduler::Requested = 0;
+size_t RedrawScheduler::Performed = 0;
+unsigned long long RedrawScheduler::PixelsTouched = 0;
+
+void RedrawScheduler::Request(HWND hWnd, bool bErase)
+{
+    Add(hWnd, nullptr, bErase);
+}
+
+void RedrawScheduler::RequestIsoView()
+{
+    if (auto pIsoView = CFinalSunDlg::Instance->MyViewFrame.pIsoView)
+        Add(pIsoView->GetSafeHwnd(), nullptr, false);
+}
+
+void RedrawScheduler::RequestCell(int X, int Y, int nMargin)
+{
+    auto pIsoView = CFinalSunDlg::Instance->MyViewFrame.pIsoView;
+    if (!pIsoView)
+        return;
+
+    int nScreenX = Y, nScreenY = X;
+    pIsoView->MapCoord2ScreenCoord(nScreenX, nScreenY);
+    nScreenX -= static_cast<int>(ScrollX);
+    nScreenY -= static_cast<int>(ScrollY);
+
+    // A tile is 60 * 30 and each height level lifts it by 15 pixels
+    RECT rect
+    {
+        nScreenX - nMargin,
+        nScreenY - 15 * 14 - nMargin,
+        nScreenX + 60 + nMargin,
+        nScreenY + 30 + nMargin
+    };
+    Add(pIsoView->GetSafeHwnd(), &rect, false);
+}
+
+void RedrawScheduler::SetViewOrigin(float fScrollX, float fScrollY)
+{
+    ScrollX = fScrollX;
+    ScrollY = fScrollY;
+}
+
+void RedrawScheduler::Add(HWND hWnd, const RECT* pRect, bool bErase)
+{
+    if (!hWnd)
+        return;
+
+    ++Requested;
+
+    auto itr = Pending.find(hWnd);
+    if (itr == Pending.end())
+    {
+        PendingRedraw redraw{ {0, 0, 0, 0}, pRect == nullptr, bErase };
+        if (pRect)
+            redraw.Rect = *pRect;
+        Pending.emplace(hWnd, redraw);
+    }
+    else
+    {
+        auto& redraw = itr->second;
+        redraw.Erase |= bErase;
+        if (!pRect)
+            redraw.Full = true;
+        else if (!redraw.Full)
+            UnionRect(&redraw.Rect, &redraw.Rect, pRect);
+    }
+
+    StartTimer();
+}
+
+void RedrawScheduler::Flush()
+{
+    StopTimer();
+
+    auto pending = std::move(Pending);
+    Pending.clear();
+
+    for (auto& [hWnd, redraw] : pending)
+    {
+        if (!IsWindow(hWnd))
+            continue;
+
+        RECT client;
+        GetClientRect(hWnd, &client);
+        RECT rect = client;
+        if (!redraw.Full && !IntersectRect(&rect, &redraw.Rect, &client))
+            continue;
+
+        InvalidateRect(hWnd, redraw.Full ? nullptr : &rect, redraw.Erase);
+        UpdateWindow(hWnd);
+
+        ++Performed;
+        PixelsTouched += static_cast<unsigned long long>(rect.right - rect.left) * (rect.bottom - rect.top);
+    }
+}
+
+void RedrawScheduler::Clear()
+{
+    if (Requested)
+        LogStats();
+
+    StopTimer();
+    Pending.clear();
+}
+
+void RedrawScheduler::LogStats()
+{
+    Logger::Debug("RedrawScheduler : %u redraws requested, %u performed, %u kilopixels touched.\n",
+        Requested, Performed, static_cast<unsigned int>(PixelsTouched / 1000));
+}
+
+void RedrawScheduler::StartTimer()
+{
+    if (Timer == NULL)
+    {
+        // Roughly one refresh of a 60Hz screen
+        if (!(Timer = SetTimer(NULL, NULL, 16, ProcessCallback)))
+        {
+            Logger::Debug("RedrawScheduler : Failed to create timer!\n");
+            Flush();
+        }
+    }
+}
+
+void RedrawScheduler::StopTimer()
+{
+    if (Timer != NULL)
+    {
+        KillTimer(NULL, Timer);
+        Timer = NULL;
+    }
+}
+
+void CALLBACK RedrawScheduler::ProcessCallback(HWND hwnd, UINT message, UINT iTimerID, DWORD dwTime)
+{
+    if (ObjectLoadQueue::IsDrawing)
+        return;
+
+    Flush();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <map>
+
+// Repaint requests are gathered here and flushed at most once per timer tick,
+// so a burst of edits or key repeats paints once. Requests for map cells only
+// invalidate the screen rectangles of those cells on the iso view.
+class RedrawScheduler
+{
+public:
+    // Repaints the whole client area of hWnd on the next tick
+    static void Request(HWND hWnd, bool bErase = false);
+    static void RequestIsoView();
+    // Repaints the cell at X, Y, nMargin pixels around it cover what is drawn above the tile
+    static void RequestCell(int X, int Y, int nMargin = DefaultCellMargin);
+
+    // The iso view scroll position of the last paint, used to place the cells
+    static void SetViewOrigin(float fScrollX, float fScrollY);
+
+    static void Flush();
+    static void Clear();
+    static void LogStats();
+
+    static constexpr int DefaultCellMargin = 64;
+    static constexpr int ObjectCellMargin = 256;
+
+private:
+    struct PendingRedraw
+    {
+        RECT Rect;
+        bool Full;
+        bool Erase;
+    };
+
+    static void Add(HWND hWnd, const RECT* pRect, bool bErase);
+    static void StartTimer();
+    static void StopTimer();
+    static void CALLBACK ProcessCallback(HWND hwnd, UINT message, UINT iTimerID, DWORD dwTime);
+
+    static UINT_PTR Timer;
+    static std::map<HWND, PendingRedraw> Pending;
+    static float ScrollX;
+    static float ScrollY;
+
+    static size_t Requested;
+    static size_t Performed;
+    static unsigned long long PixelsTouched;
+};
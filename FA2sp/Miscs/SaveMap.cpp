@@ -10,11 +10,24 @@
 
 #include "../FA2sp.h"
 #include "../FA2sp.Constants.h"
+#include "../Helpers/STDHelpers.h"
+#include "MapSerializer.h"
 
 #include <map>
+#include <chrono>
 #include <fstream>
 #include <format>
 
+// Maps used to be written by a text mode stream, so lines keep ending with CRLF
+static constexpr const char MapFileHeader[] =
+    "; Map created with FinalAlert 2(tm) Mission Editor\r\n"
+    "; Get it at http://www.westwood.com\r\n"
+    "; note that all comments were truncated\r\n"
+    "\r\n"
+    "; This FA2 uses FA2sp created by secsome\r\n"
+    "; Get the lastest dll at https://github.com/secsome/FA2sp\r\n"
+    "; Current version : " PRODUCT_STR "\r\n\r\n";
+
 // FA2 SaveMap is almost O(N^4), who wrote that?
 DEFINE_HOOK(428D97, CFinalSunDlg_SaveMap, 7)
 {
@@ -29,37 +42,13 @@ DEFINE_HOOK(428D97, CFinalSunDlg_SaveMap, 7)
         pThis->MyViewFrame.StatusBar.SetWindowText("Saving...");
         pThis->MyViewFrame.StatusBar.UpdateWindow();
 
-        ppmfc::CString buffer;
-        buffer.Format("%d", pINI->GetInteger("FA2spVersionControl", "Version") + 1);
-        pINI->WriteString("FA2spVersionControl", "Version", buffer);
-
-        Logger::Raw("SaveMap : Now removing empty sections and keys.\n");
-        std::vector<ppmfc::CString> sectionsToRemove;
-        for (auto& section_pair : pINI->Dict)
+        // Auto saves keep the version, otherwise an unchanged map would never hash the same
+        if (!SaveMapExt::IsBackgroundSaving)
         {
             ppmfc::CString buffer;
-            buffer = section_pair.first;
-            buffer.Trim();
-            if (buffer.GetLength() == 0 || section_pair.second.GetEntities().size() == 0)
-                sectionsToRemove.push_back(section_pair.first);
-
-            std::vector<ppmfc::CString> keysToRemove;
-            for (auto& key_pair : section_pair.second.GetEntities())
-            {
-                buffer = key_pair.first;
-                buffer.Trim();
-                if (buffer.GetLength() == 0)
-                    keysToRemove.push_back(key_pair.first);
-            }
-
-            for (auto& key : keysToRemove)
-                pINI->DeleteKey(section_pair.first, key);
-
-            if (section_pair.second.GetEntities().size() == 0)
-                sectionsToRemove.push_back(section_pair.first);
+            buffer.Format("%d", pINI->GetInteger("FA2spVersionControl", "Version") + 1);
+            pINI->WriteString("FA2spVersionControl", "Version", buffer);
         }
-        for (auto& section : sectionsToRemove)
-            pINI->DeleteSection(section);
 
         if (bGeneratePreview)
         {
@@ -80,34 +69,42 @@ DEFINE_HOOK(428D97, CFinalSunDlg_SaveMap, 7)
                 filepath = filepath.Mid(0, nExtIndex) + ".map";
         }
 
+        if (SaveMapExt::IsBackgroundSaving)
+        {
+            SaveMapExt::WriteMapAsync(pINI, filepath);
+            return 0x42A859;
+        }
+
         Logger::FormatLog("SaveMap : Trying to save map to {}.\n", filepath);
 
-        std::ofstream fout;
-        fout.open(filepath, std::ios::out | std::ios::trunc);
+        // Saving over the file the auto save is still writing
+        SaveMapExt::JoinAutoSaveThread(filepath);
+
+        // Empty sections and blank keys are dropped while formatting
+        auto begin = std::chrono::steady_clock::now();
+
+        std::vector<MapSerializer::Section> sections;
+        sections.reserve(pINI->Dict.size());
+        for (auto& section : pINI->Dict)
+        {
+            auto& entries = sections.emplace_back(
+                MapSerializer::Section{ std::string_view(section.first, section.first.GetLength()), {} }).Entries;
+            const auto& entities = section.second.GetEntities();
+            entries.reserve(entities.size());
+            for (auto& pair : entities)
+                entries.emplace_back(std::string_view(pair.first, pair.first.GetLength()),
+                    std::string_view(pair.second, pair.second.GetLength()));
+        }
+        auto buffer = MapSerializer::Serialize(MapFileHeader, sections);
 
-        if (fout.is_open())
+        auto serialized = std::chrono::steady_clock::now();
+
+        if (MapSerializer::WriteFile(filepath, buffer))
         {
-            fout <<
-                "; Map created with FinalAlert 2(tm) Mission Editor\n"
-                "; Get it at http://www.westwood.com\n"
-                "; note that all comments were truncated\n"
-                "\n"
-                "; This FA2 uses FA2sp created by secsome\n"
-                "; Get the lastest dll at https://github.com/secsome/FA2sp\n"
-                "; Current version : " << PRODUCT_STR << "\n\n";
-
-            for (auto& section : pINI->Dict)
-            {
-                fout << "[" << section.first << "]\n";
-                for (auto& pair : section.second.GetEntities())
-                    fout << pair.first << "=" << pair.second << "\n";
-                fout << "\n";
-            }
-
-            fout.flush();
-            fout.close();
-
-            Logger::FormatLog("SaveMap : Successfully saved {} sections.\n", pINI->Dict.size());
+            Logger::FormatLog("SaveMap : Successfully saved {} sections, {} bytes, serialize {} ms, write {} ms.\n",
+                pINI->Dict.size(), buffer.size(),
+                std::chrono::duration_cast<std::chrono::milliseconds>(serialized - begin).count(),
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - serialized).count());
         }
         else
         {
@@ -175,82 +172,144 @@ void SaveMapExt::StopTimer()
     }
 }
 
-void SaveMapExt::RemoveEarlySaves()
+bool SaveMapExt::WriteMapAsync(CINI* pINI, const char* lpPath)
 {
-    if (ExtConfigs::SaveMap_AutoSave_MaxCount != -1)
+    auto begin = std::chrono::steady_clock::now();
+
+    std::string directory = lpPath;
+    directory.erase(directory.find_last_of('\\') + 1);
+    if (directory != LastDirectory || AutoSaveFailed.exchange(false))
     {
-        struct FileTimeComparator
-        {
-            bool operator()(const FILETIME& a, const FILETIME& b) const { return CompareFileTime(&a, &b) == -1; }
-        };
-
-        std::map<FILETIME, ppmfc::CString, FileTimeComparator> m;
-        auto mapName = CINI::CurrentDocument->GetString("Basic", "Name", "No Name");
-
-        /*
-        * Fix : Windows file name cannot begin with space and cannot have following characters:
-        * \ / : * ? " < > |
-        */
-        for (int i = 0; i < mapName.GetLength(); ++i)
-            if (mapName[i] == '\\' || mapName[i] == '/' || mapName[i] == ':' ||
-                mapName[i] == '*' || mapName[i] == '?' || mapName[i] == '"' ||
-                mapName[i] == '<' || mapName[i] == '>' || mapName[i] == '|'
-                )
-                mapName.SetAt(i, '-');
-
-        const auto ext =
-            !ExtConfigs::SaveMap_OnlySaveMAP && CMapData::Instance->IsMultiOnly() ?
-            CLoading::HasMdFile() ?
-            "yrm" :
-            "mpr" :
-            "map";
-
-        ppmfc::CString buffer;
-        buffer.Format("%s\\AutoSaves\\%s\\%s-*.%s",
-            CFinalSunApp::ExePath(),
-            mapName,
-            mapName,
-            ext
-        );
-
-        WIN32_FIND_DATA Data;
-        auto hFindData = FindFirstFile(buffer, &Data);
-        while (hFindData != INVALID_HANDLE_VALUE)
+        LastSections.clear();
+        LastRootHash = 0;
+    }
+
+    // Only sections whose hash changed since the last auto save are copied again
+    MapSnapshot snapshot;
+    snapshot.Path = lpPath;
+    snapshot.IndexPattern = AutoSavePattern;
+    snapshot.Sections.reserve(pINI->Dict.size());
+    unsigned long long nRootHash = STDHelpers::FNVOffsetBasis64;
+    size_t nCopied = 0;
+    for (auto& section : pINI->Dict)
+    {
+        const auto& entities = section.second.GetEntities();
+        // Keys and values are terminated so "a=bc" and "ab=c" differ
+        unsigned long long nHash = STDHelpers::FNVOffsetBasis64;
+        STDHelpers::HashString(nHash, section.first, section.first.GetLength());
+        for (auto& pair : entities)
         {
-            m[Data.ftLastWriteTime] = Data.cFileName;
-            if (!FindNextFile(hFindData, &Data))
-                break;
+            STDHelpers::HashString(nHash, pair.first, pair.first.GetLength());
+            STDHelpers::HashString(nHash, pair.second, pair.second.GetLength());
         }
+        STDHelpers::HashString(nRootHash, reinterpret_cast<const char*>(&nHash), sizeof(nHash));
 
-        int count = m.size() - ExtConfigs::SaveMap_AutoSave_MaxCount;
-        if (count <= 0)
-            return;
-
-        auto& itr = m.begin();
-        while (count != 0)
+        std::string name(section.first, section.first.GetLength());
+        auto itr = LastSections.find(name);
+        if (itr != LastSections.end() && itr->second->Hash == nHash)
         {
-            buffer.Format("%s\\AutoSaves\\%s\\%s", CFinalSunApp::ExePath(), mapName, itr->second);
-            DeleteFile(buffer);
-            ++itr;
-            --count;
+            snapshot.Sections.push_back(itr->second);
+            continue;
         }
+
+        auto pSection = std::make_shared<SectionSnapshot>();
+        pSection->Name = std::move(name);
+        pSection->Hash = nHash;
+        pSection->Entries.reserve(entities.size());
+        for (auto& pair : entities)
+            pSection->Entries.emplace_back(
+                std::string(pair.first, pair.first.GetLength()), std::string(pair.second, pair.second.GetLength()));
+        snapshot.Sections.push_back(std::move(pSection));
+        ++nCopied;
     }
+
+    auto time = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+
+    if (directory == LastDirectory && nRootHash == LastRootHash)
+    {
+        ++SkippedAutoSaves;
+        Logger::Debug("SaveMap : Map unchanged since the last auto save, skipped. Hashing took %d ms, %u written, %u skipped.\n",
+            time, WrittenAutoSaves, SkippedAutoSaves);
+        return false;
+    }
+
+    ++WrittenAutoSaves;
+    Logger::Debug("SaveMap : Auto save snapshot of %u sections, %u copied, took %d ms. %u written, %u skipped.\n",
+        snapshot.Sections.size(), nCopied, time, WrittenAutoSaves, SkippedAutoSaves);
+
+    LastSections.clear();
+    for (auto& pSection : snapshot.Sections)
+        LastSections.emplace(pSection->Name, pSection);
+    LastRootHash = nRootHash;
+    LastDirectory = std::move(directory);
+
+    // The callback skips while the last one is busy, so this only reaps a finished thread
+    JoinAutoSaveThread();
+    AutoSaveBusy = true;
+    AutoSavePath = snapshot.Path;
+    AutoSaveThread = std::thread(WriteSnapshot, std::move(snapshot));
+
+    return true;
 }
 
-void CALLBACK SaveMapExt::SaveMapCallback(HWND hwnd, UINT message, UINT iTimerID, DWORD dwTime)
+void SaveMapExt::WriteSnapshot(MapSnapshot snapshot)
 {
-    Logger::Debug("SaveMapCallback called, trying to auto save map. hwnd = %08X, message = %d, iTimerID = %d, dwTime = %d.\n",
-        hwnd, message, iTimerID, dwTime);
+    auto begin = std::chrono::steady_clock::now();
 
-    if (!CMapData::Instance->MapWidthPlusHeight || !CMapData::Instance->FieldDataAllocated)
+    std::vector<MapSerializer::Section> sections;
+    sections.reserve(snapshot.Sections.size());
+    for (auto& pSection : snapshot.Sections)
     {
-        StopTimer();
-        return;
+        auto& entries = sections.emplace_back(MapSerializer::Section{ pSection->Name, {} }).Entries;
+        entries.reserve(pSection->Entries.size());
+        for (auto& [key, value] : pSection->Entries)
+            entries.emplace_back(key, value);
     }
+    auto buffer = MapSerializer::Serialize(MapFileHeader, sections);
 
-    SYSTEMTIME time;
-    GetLocalTime(&time);
+    auto serialized = std::chrono::steady_clock::now();
+
+    bool bSuccess = MapSerializer::WriteFile(snapshot.Path.c_str(), buffer);
+
+    auto end = std::chrono::steady_clock::now();
+
+    if (bSuccess)
+    {
+        Logger::Debug("SaveMap : Auto saved %s, serialize %d ms, write %d ms, %u bytes.\n",
+            snapshot.Path.c_str(),
+            static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(serialized - begin).count()),
+            static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(end - serialized).count()),
+            buffer.size());
+
+        // Only listed once it was renamed into place, a failed save never pushes out a good one
+        auto nPos = snapshot.Path.find_last_of('\\');
+        RemoveEarlySaves(snapshot.Path.substr(0, nPos), snapshot.IndexPattern, snapshot.Path.substr(nPos + 1));
+    }
+    else
+    {
+        AutoSaveFailed = true;
+        Logger::Debug("SaveMap : Failed to auto save %s, error %u.\n", snapshot.Path.c_str(), GetLastError());
+    }
+
+    AutoSaveBusy = false;
+}
+
+void SaveMapExt::JoinAutoSaveThread(const char* lpPath)
+{
+    if (!AutoSaveThread.joinable())
+        return;
+    if (lpPath && _stricmp(lpPath, AutoSavePath.c_str()) != 0)
+        return;
 
+    auto begin = std::chrono::steady_clock::now();
+    AutoSaveThread.join();
+    Logger::Debug("SaveMap : Waited %d ms for the auto save of %s.\n",
+        static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count()),
+        AutoSavePath.c_str());
+}
+
+ppmfc::CString SaveMapExt::GetAutoSaveName()
+{
     auto mapName = CINI::CurrentDocument->GetString("Basic", "Name", "No Name");
 
     /*
@@ -264,6 +323,97 @@ void CALLBACK SaveMapExt::SaveMapCallback(HWND hwnd, UINT message, UINT iTimerID
             )
             mapName.SetAt(i, '-');
 
+    return mapName;
+}
+
+std::vector<std::string> SaveMapExt::ReadAutoSaveIndex(const std::string& Directory, const std::string& Pattern)
+{
+    std::vector<std::string> ret;
+
+    std::ifstream fin;
+    fin.open(Directory + "\\index.txt", std::ios::in);
+    if (fin.is_open())
+    {
+        std::string line;
+        while (std::getline(fin, line))
+            if (!line.empty())
+                ret.push_back(line);
+        return ret;
+    }
+
+    // No index yet, build it from the saves already in the folder
+    struct FileTimeComparator
+    {
+        bool operator()(const FILETIME& a, const FILETIME& b) const { return CompareFileTime(&a, &b) == -1; }
+    };
+
+    std::map<FILETIME, std::string, FileTimeComparator> m;
+
+    WIN32_FIND_DATA Data;
+    auto hFindData = FindFirstFile((Directory + "\\" + Pattern).c_str(), &Data);
+    while (hFindData != INVALID_HANDLE_VALUE)
+    {
+        m[Data.ftLastWriteTime] = Data.cFileName;
+        if (!FindNextFile(hFindData, &Data))
+        {
+            FindClose(hFindData);
+            break;
+        }
+    }
+
+    for (auto& pair : m)
+        ret.push_back(pair.second);
+
+    return ret;
+}
+
+void SaveMapExt::RemoveEarlySaves(const std::string& Directory, const std::string& Pattern, const std::string& NewFile)
+{
+    auto saves = ReadAutoSaveIndex(Directory, Pattern);
+    saves.push_back(NewFile);
+
+    if (ExtConfigs::SaveMap_AutoSave_MaxCount != -1)
+    {
+        int count = saves.size() - ExtConfigs::SaveMap_AutoSave_MaxCount;
+        if (count > 0)
+        {
+            for (int i = 0; i < count; ++i)
+                DeleteFile((Directory + "\\" + saves[i]).c_str());
+            saves.erase(saves.begin(), saves.begin() + count);
+        }
+    }
+
+    std::ofstream fout;
+    fout.open(Directory + "\\index.txt", std::ios::out | std::ios::trunc);
+    if (fout.is_open())
+    {
+        for (auto& save : saves)
+            fout << save << "\n";
+    }
+}
+
+void CALLBACK SaveMapExt::SaveMapCallback(HWND hwnd, UINT message, UINT iTimerID, DWORD dwTime)
+{
+    Logger::Debug("SaveMapCallback called, trying to auto save map. hwnd = %08X, message = %d, iTimerID = %d, dwTime = %d.\n",
+        hwnd, message, iTimerID, dwTime);
+
+    if (!CMapData::Instance->MapWidthPlusHeight || !CMapData::Instance->FieldDataAllocated)
+    {
+        StopTimer();
+        return;
+    }
+
+    if (AutoSaveBusy)
+    {
+        Logger::Debug("SaveMapCallback : Last auto save is still being written, skipped.\n");
+        return;
+    }
+
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+
+    auto mapName = GetAutoSaveName();
+
     const auto ext =
         !ExtConfigs::SaveMap_OnlySaveMAP && CMapData::Instance->IsMultiOnly() ?
         CLoading::HasMdFile() ?
@@ -271,15 +421,14 @@ void CALLBACK SaveMapExt::SaveMapCallback(HWND hwnd, UINT message, UINT iTimerID
         "mpr" :
         "map";
 
-    ppmfc::CString buffer = CFinalSunApp::ExePath();
-    buffer += "\\AutoSaves\\";
-    CreateDirectory(buffer, nullptr);
-    buffer += mapName;
-    CreateDirectory(buffer, nullptr);
+    ppmfc::CString directory = CFinalSunApp::ExePath();
+    directory += "\\AutoSaves\\";
+    CreateDirectory(directory, nullptr);
+    directory += mapName;
+    CreateDirectory(directory, nullptr);
 
-    buffer.Format("%s\\AutoSaves\\%s\\%s-%04d%02d%02d-%02d%02d%02d-%03d.%s",
-        CFinalSunApp::ExePath(),
-        mapName,
+    ppmfc::CString filename;
+    filename.Format("%s-%04d%02d%02d-%02d%02d%02d-%03d.%s",
         mapName,
         time.wYear, time.wMonth, time.wDay,
         time.wHour, time.wMinute, time.wSecond,
@@ -287,15 +436,39 @@ void CALLBACK SaveMapExt::SaveMapCallback(HWND hwnd, UINT message, UINT iTimerID
         ext
     );
 
+    ppmfc::CString pattern;
+    pattern.Format("%s-*.%s", mapName, ext);
+    AutoSavePattern = pattern;
+
+    auto begin = std::chrono::steady_clock::now();
+
     IsAutoSaving = true;
-    CFinalSunDlg::Instance->SaveMap(buffer);
+    IsBackgroundSaving = ExtConfigs::SaveMap;
+    CFinalSunDlg::Instance->SaveMap(directory + "\\" + filename);
+    IsBackgroundSaving = false;
     IsAutoSaving = false;
 
-    RemoveEarlySaves();
+    // Background saves update the index from their thread, once the file is written
+    if (!ExtConfigs::SaveMap && GetFileAttributes(directory + "\\" + filename) != INVALID_FILE_ATTRIBUTES)
+        RemoveEarlySaves(std::string(directory), std::string(pattern), std::string(filename));
+
+    Logger::Debug("SaveMapCallback : Returned to the UI after %d ms.\n",
+        static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count()));
 }
 
 bool SaveMapExt::IsAutoSaving = false;
+bool SaveMapExt::IsBackgroundSaving = false;
 UINT_PTR SaveMapExt::Timer = NULL;
+std::thread SaveMapExt::AutoSaveThread;
+std::string SaveMapExt::AutoSavePath;
+std::string SaveMapExt::AutoSavePattern;
+std::atomic<bool> SaveMapExt::AutoSaveBusy = false;
+std::atomic<bool> SaveMapExt::AutoSaveFailed = false;
+std::map<std::string, std::shared_ptr<const SaveMapExt::SectionSnapshot>> SaveMapExt::LastSections;
+unsigned long long SaveMapExt::LastRootHash = 0;
+std::string SaveMapExt::LastDirectory;
+size_t SaveMapExt::WrittenAutoSaves = 0;
+size_t SaveMapExt::SkippedAutoSaves = 0;
 
 
 DEFINE_HOOK(426E50, CFinalSunDlg_SaveMap_AutoSave_StopTimer, 7)
@@ -324,6 +497,7 @@ DEFINE_HOOK(437D84, CFinalSunDlg_LoadMap_StopTimer, 5)
 {
     if (ExtConfigs::SaveMap_AutoSave)
         SaveMapExt::StopTimer();
+    SaveMapExt::JoinAutoSaveThread();
     return 0;
 }
 
@@ -338,6 +512,7 @@ DEFINE_HOOK(42CBE0, CFinalSunDlg_CreateMap_StopTimer, 5)
 {
     if (ExtConfigs::SaveMap_AutoSave)
         SaveMapExt::StopTimer();
+    SaveMapExt::JoinAutoSaveThread();
     return 0;
 }
 
@@ -4,16 +4,66 @@
 
 #include "../FA2sp.h"
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CINI;
+
 class SaveMapExt
 {
 private:
     static UINT_PTR Timer;
+
+    // A plain copy of one section, shared between snapshots while its content stays the same
+    struct SectionSnapshot
+    {
+        std::string Name;
+        std::vector<std::pair<std::string, std::string>> Entries;
+        unsigned long long Hash;
+    };
+
+    // A plain copy of the document taken on the UI thread, so the
+    // auto save can be formatted and written while editing goes on
+    struct MapSnapshot
+    {
+        std::string Path;
+        std::string IndexPattern; // of the saves listed in index.txt beside it
+        std::vector<std::shared_ptr<const SectionSnapshot>> Sections;
+    };
+
+    static void WriteSnapshot(MapSnapshot snapshot);
+    static ppmfc::CString GetAutoSaveName();
+    static std::vector<std::string> ReadAutoSaveIndex(const std::string& Directory, const std::string& Pattern);
+    // Adds NewFile to index.txt and deletes the oldest saves above the limit, safe off the UI thread
+    static void RemoveEarlySaves(const std::string& Directory, const std::string& Pattern, const std::string& NewFile);
+
+    static std::thread AutoSaveThread;
+    static std::string AutoSavePath; // of the file AutoSaveThread writes
+    static std::string AutoSavePattern; // of the auto save being taken
+    static std::atomic<bool> AutoSaveBusy;
+    static std::atomic<bool> AutoSaveFailed;
+
+    // Sections of the last written auto save, and the hash over all of them
+    static std::map<std::string, std::shared_ptr<const SectionSnapshot>> LastSections;
+    static unsigned long long LastRootHash;
+    static std::string LastDirectory;
+    static size_t WrittenAutoSaves;
+    static size_t SkippedAutoSaves;
+
 public:
     static bool IsAutoSaving;
+    static bool IsBackgroundSaving;
     static ppmfc::CString FileName;
 
     static void ResetTimer();
     static void StopTimer();
-    static void RemoveEarlySaves();
+    // Waits for the auto save being written, if any. With a path given, only if it writes to that file
+    static void JoinAutoSaveThread(const char* lpPath = nullptr);
+    // Returns false if the content equals the last auto save in the same folder and nothing was written
+    static bool WriteMapAsync(CINI* pINI, const char* lpPath);
     static void CALLBACK SaveMapCallback(HWND hwnd, UINT message, UINT iTimerID, DWORD dwTime);
 };
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "TypeClassification.h"
+
+#include <CINI.h>
+#include <CMapData.h>
+
+#include "DocumentVersion.h"
+#include "../Helpers/STDHelpers.h"
+
+#include <chrono>
+
+std::map<ppmfc::CString, TypeClassification::Record> TypeClassification::Records;
+std::vector<std::pair<int, TypeClassification::Record*>> TypeClassification::Lists[Count];
+std::set<ppmfc::CString> TypeClassification::Sets[Count];
+std::set<ppmfc::CString> TypeClassification::IgnoreSet;
+std::set<ppmfc::CString> TypeClassification::ForceNameSet;
+std::map<ppmfc::CString, int> TypeClassification::KnownSides;
+std::map<ppmfc::CString, int> TypeClassification::Owners;
+unsigned int TypeClassification::Signature = 0;
+unsigned int TypeClassification::Generation = 0;
+unsigned int TypeClassification::Version = 0;
+unsigned int TypeClassification::CheckedVersion = 0;
+bool TypeClassification::Valid = false;
+
+namespace
+{
+    const char* const TypeLists[TypeClassification::Count] =
+    {
+        "BuildingTypes", "InfantryTypes", "VehicleTypes", "AircraftTypes"
+    };
+}
+
+void TypeClassification::Update()
+{
+    if (Valid && CheckedVersion == DocumentVersion::Get())
+        return;
+
+    auto begin = std::chrono::steady_clock::now();
+    CheckedVersion = DocumentVersion::Get();
+
+    unsigned int nSignature = GetSignature();
+    bool bFull = !Valid || nSignature != Signature;
+    if (bFull)
+    {
+        Records.clear();
+        LoadSettings();
+        Signature = nSignature;
+        Valid = true;
+    }
+
+    ++Generation;
+    size_t nChanged = 0;
+    for (int i = 0; i < Count; ++i)
+    {
+        Lists[i].clear();
+        for (auto& pair : Variables::Rules.GetSection(TypeLists[i]))
+        {
+            auto& record = Records[pair.second];
+            if (record.Generation != Generation)
+            {
+                unsigned int nHash = GetSectionHash(pair.second);
+                if (record.RegName.IsEmpty() || record.SectionHash != nHash)
+                {
+                    record.RegName = pair.second;
+                    record.UIName = CMapData::GetUIName(pair.second);
+                    record.SectionHash = nHash;
+                    ++nChanged;
+                }
+                record.CheckedVersion = CheckedVersion;
+                record.Category = i;
+                record.Generation = Generation;
+            }
+            Lists[i].emplace_back(STDHelpers::ParseToInt(pair.first, -1), &record);
+        }
+    }
+
+    for (auto itr = Records.begin(); itr != Records.end();)
+    {
+        if (itr->second.Generation != Generation)
+        {
+            itr = Records.erase(itr);
+            ++nChanged;
+        }
+        else
+            ++itr;
+    }
+
+    // A side may come from the prerequisites, so all of them are guessed again
+    // once any type changed. It's the names that are expensive, not this.
+    if (bFull || nChanged)
+        ++Version;
+
+    if (nChanged)
+    {
+        auto& fadata = CINI::FAData();
+
+        KnownSides.clear();
+        if (auto knownSection = fadata.GetSection("ForceSides"))
+        {
+            for (auto& item : knownSection->GetEntities())
+            {
+                int sideIndex = STDHelpers::ParseToInt(item.second, -1);
+                if (sideIndex >= fadata.GetKeyCount("Sides"))
+                    continue;
+                if (sideIndex < -1)
+                    sideIndex = -1;
+                KnownSides[item.first] = sideIndex;
+            }
+        }
+
+        for (auto& pair : Records)
+            pair.second.Side = GuessSide(pair.first, pair.second.Category);
+    }
+
+    Logger::Debug("TypeClassification : %u types, %u classified again (%s) in %d us.\n",
+        Records.size(), nChanged, bFull ? "full" : "incremental",
+        static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count()));
+}
+
+void TypeClassification::Clear()
+{
+    Records.clear();
+    for (auto& list : Lists)
+        list.clear();
+    for (auto& set : Sets)
+        set.clear();
+    IgnoreSet.clear();
+    ForceNameSet.clear();
+    KnownSides.clear();
+    Owners.clear();
+    Valid = false;
+    ++Version;
+}
+
+const TypeClassification::Record* TypeClassification::Find(const char* pRegName)
+{
+    auto itr = Records.find(pRegName);
+    return itr != Records.end() ? &itr->second : nullptr;
+}
+
+const std::vector<std::pair<int, TypeClassification::Record*>>& TypeClassification::GetTypes(int nCategory)
+{
+    return Lists[nCategory];
+}
+
+ppmfc::CString TypeClassification::GetUIName(const char* pRegName)
+{
+    auto itr = Records.find(pRegName);
+    if (itr == Records.end())
+        return CMapData::GetUIName(pRegName);
+
+    // The record is left to Update, which has to see the change to classify the type again
+    auto& record = itr->second;
+    if (record.CheckedVersion != DocumentVersion::Get())
+    {
+        if (record.SectionHash != GetSectionHash(pRegName))
+            return CMapData::GetUIName(pRegName);
+        record.CheckedVersion = DocumentVersion::Get();
+    }
+    return record.UIName;
+}
+
+bool TypeClassification::IsIgnored(const char* pRegName)
+{
+    return IgnoreSet.find(pRegName) != IgnoreSet.end();
+}
+
+bool TypeClassification::IsForceName(const char* pRegName)
+{
+    return ForceNameSet.find(pRegName) != ForceNameSet.end();
+}
+
+int TypeClassification::GuessType(const char* pRegName)
+{
+    if (Sets[Building].find(pRegName) != Sets[Building].end())
+        return Building;
+    if (Sets[Infantry].find(pRegName) != Sets[Infantry].end())
+        return Infantry;
+    if (Sets[Vehicle].find(pRegName) != Sets[Vehicle].end())
+        return Vehicle;
+    if (Sets[Aircraft].find(pRegName) != Sets[Aircraft].end())
+        return Aircraft;
+    return -1;
+}
+
+void TypeClassification::LoadSettings()
+{
+    auto& fadata = CINI::FAData();
+
+    for (int i = 0; i < Count; ++i)
+    {
+        Sets[i].clear();
+        for (auto& itr : Variables::Rules.GetSection(TypeLists[i]))
+            Sets[i].insert(itr.second);
+    }
+
+    Owners.clear();
+    if (ExtConfigs::BrowserRedraw_GuessMode == 1)
+    {
+        auto sides = Variables::Rules.ParseIndicies("Sides", true);
+        for (size_t i = 0, sz = sides.size(); i < sz; ++i)
+            for (auto& owner : STDHelpers::SplitString(sides[i]))
+                Owners[owner] = i;
+    }
+
+    IgnoreSet.clear();
+    if (auto ignores = fadata.GetSection("IgnoreRA2"))
+        for (auto& item : ignores->GetEntities())
+            IgnoreSet.insert(item.second);
+
+    ForceNameSet.clear();
+    if (auto forcenames = fadata.GetSection("ForceName"))
+        for (auto& item : forcenames->GetEntities())
+            ForceNameSet.insert(item.second);
+}
+
+unsigned int TypeClassification::GetSignature()
+{
+    // Everything the classification reads besides the types' own sections
+    unsigned int nHash = STDHelpers::FNVOffsetBasis32;
+    STDHelpers::HashString(nHash, ExtConfigs::BrowserRedraw_GuessMode ? "1" : "0");
+    for (auto pSection : { "Sides", "ForceSides", "IgnoreRA2", "ForceName" })
+        STDHelpers::HashSection(nHash, &CINI::FAData(), pSection);
+    for (auto pSection : TypeLists)
+        for (auto& pair : Variables::Rules.GetSection(pSection))
+        {
+            STDHelpers::HashString(nHash, pair.first);
+            STDHelpers::HashString(nHash, pair.second);
+        }
+    for (auto pSection : { "Sides", "GenericPrerequisites", "AI" })
+    {
+        STDHelpers::HashSection(nHash, &CINI::Rules(), pSection);
+        STDHelpers::HashSection(nHash, &CINI::CurrentDocument(), pSection);
+    }
+    return nHash;
+}
+
+unsigned int TypeClassification::GetSectionHash(const char* pRegName)
+{
+    unsigned int nHash = STDHelpers::FNVOffsetBasis32;
+    STDHelpers::HashSection(nHash, &CINI::CurrentDocument(), pRegName);
+    return nHash;
+}
+
+int TypeClassification::GuessSide(const char* pRegName, int nType)
+{
+    auto knownIterator = KnownSides.find(pRegName);
+    if (knownIterator != KnownSides.end())
+        return knownIterator->second;
+
+    int result = -1;
+    switch (nType)
+    {
+    case -1:
+    default:
+        break;
+    case Building:
+        result = GuessBuildingSide(pRegName);
+        break;
+    case Infantry:
+        result = GuessGenericSide(pRegName, Infantry);
+        break;
+    case Vehicle:
+        result = GuessGenericSide(pRegName, Vehicle);
+        break;
+    case Aircraft:
+        result = GuessGenericSide(pRegName, Aircraft);
+        break;
+    }
+    KnownSides[pRegName] = result;
+    return result;
+}
+
+int TypeClassification::GuessBuildingSide(const char* pRegName)
+{
+    auto& rules = CINI::Rules();
+
+    int planning;
+    planning = rules.GetInteger(pRegName, "AIBasePlanningSide", -1);
+    if (planning >= rules.GetKeyCount("Sides"))
+        return -1;
+    if (planning >= 0)
+        return planning;
+    auto cons = STDHelpers::SplitString(rules.GetString("AI", "BuildConst"));
+    int i;
+    for (i = 0; i < cons.size(); ++i)
+    {
+        if (cons[i] == pRegName)
+            return i;
+    }
+    if (i >= rules.GetKeyCount("Sides"))
+        return -1;
+    return GuessGenericSide(pRegName, Building);
+}
+
+int TypeClassification::GuessGenericSide(const char* pRegName, int nType)
+{
+    const auto& set = Sets[nType];
+
+    if (set.find(pRegName) == set.end())
+        return -1;
+
+    switch (ExtConfigs::BrowserRedraw_GuessMode)
+    {
+    default:
+    case 0:
+    {
+        for (auto& prep : STDHelpers::SplitString(Variables::Rules.GetString(pRegName, "Prerequisite")))
+        {
+            int guess = -1;
+            for (auto& subprep : STDHelpers::SplitString(Variables::Rules.GetString("GenericPrerequisites", prep)))
+            {
+                guess = GuessSide(subprep, GuessType(subprep));
+                if (guess != -1)
+                    return guess;
+            }
+            guess = GuessSide(prep, GuessType(prep));
+            if (guess != -1)
+                return guess;
+        }
+        return -1;
+    }
+    case 1:
+    {
+        auto owners = STDHelpers::SplitString(Variables::Rules.GetString(pRegName, "Owner"));
+        if (owners.size() <= 0)
+            return -1;
+        auto itr = Owners.find(owners[0]);
+        if (itr == Owners.end())
+            return -1;
+        return itr->second;
+    }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../FA2sp.h"
+
+#include <MFC/ppmfc_cstring.h>
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Category, guessed side and UI name of every building, infantry, vehicle and aircraft type,
+// worked out in one pass and shared by the object browser and the combobox loaders.
+// Update() does nothing until the document version moved, then only classifies the types
+// again whose sections in the map changed. Everything is done again when the type lists,
+// FAData or the guessing settings change.
+class TypeClassification
+{
+public:
+    // Same order as the object browser sets
+    enum
+    {
+        Building = 0, Infantry, Vehicle, Aircraft, Count
+    };
+
+    struct Record
+    {
+        ppmfc::CString RegName;
+        ppmfc::CString UIName; // CMapData::GetUIName
+        int Category = -1; // first list the type is in
+        int Side = -1; // -1 if it can't be guessed
+        unsigned int SectionHash = 0; // of the type's section in the map
+        unsigned int CheckedVersion = 0; // document version SectionHash was last compared at
+        unsigned int Generation = 0;
+    };
+
+    static void Update();
+    static void Clear();
+    // Changes whenever an Update changed any record, the same value means the same table
+    static unsigned int GetVersion() { return Version; }
+
+    static const Record* Find(const char* pRegName);
+    // Key in the type list (-1 if not a number) and record, in the order of the list
+    static const std::vector<std::pair<int, Record*>>& GetTypes(int nCategory);
+
+    // Cached name if the type's section in the map is unchanged, CMapData::GetUIName otherwise.
+    // The section is only hashed again once the document version moved.
+    static ppmfc::CString GetUIName(const char* pRegName);
+    static bool IsIgnored(const char* pRegName);
+    static bool IsForceName(const char* pRegName);
+
+    /// <summary>
+    /// Guess which type does the item belongs to.
+    /// </summary>
+    /// <param name="pRegName">Reg name of the given item.</param>
+    /// <returns>
+    /// The index of type guessed. -1 if cannot be guessed.
+    /// 0 = Building, 1 = Infantry, 2 = Vehicle, 3 = Aircraft
+    /// </returns>
+    static int GuessType(const char* pRegName);
+
+private:
+    static void LoadSettings();
+    static unsigned int GetSignature();
+    static unsigned int GetSectionHash(const char* pRegName);
+
+    static int GuessSide(const char* pRegName, int nType);
+    static int GuessBuildingSide(const char* pRegName);
+    static int GuessGenericSide(const char* pRegName, int nType);
+
+    static std::map<ppmfc::CString, Record> Records;
+    static std::vector<std::pair<int, Record*>> Lists[Count];
+    static std::set<ppmfc::CString> Sets[Count];
+    static std::set<ppmfc::CString> IgnoreSet;
+    static std::set<ppmfc::CString> ForceNameSet;
+    static std::map<ppmfc::CString, int> KnownSides; // [ForceSides] and the sides guessed so far
+    static std::map<ppmfc::CString, int> Owners;
+    static unsigned int Signature;
+    static unsigned int Generation;
+    static unsigned int Version;
+    static unsigned int CheckedVersion; // document version of the last Update
+    static bool Valid;
+};